@@ -0,0 +1,154 @@
+"""按句流水线的回复 (设备端解析见 src/services/network/ChatReplyParser.h)
+
+不等 LLM 说完、也不等整段 TTS：
+1. LLM 流式输出的 token 在后台线程里按句号/问号等断句，每凑出一句就放进队列；
+2. 响应生成器从队列里取句子，合成一句就发一句: 'C' (这一句的文字) + 若干 'A' (这一句的完整 WAV)；
+3. 设备把每一句接在播放队列后面，第 N 句在播的时候第 N+1 句还在合成/传输。
+
+LLM/TTS 都通过参数传进来，本地调试用下面的 stub_* 代替 DeepSeek 和 edge-tts:
+    python3 reply_pipeline.py            # 在 5000 端口起一个只有桩实现的服务器，设备直接连它
+"""
+import json
+import math
+import queue
+import struct
+import threading
+import time
+
+# "CHT1" + 若干条 { type(1) | length(4, 小端) | payload }
+# 'J' JSON 元数据 (第一条)，'C' 新的一句 (payload = 文字)，'A' 音频，'E' 结束
+REPLY_MAGIC = b"CHT1"
+REPLY_AUDIO_CHUNK = 16 * 1024
+
+# 断句的标点；太短的句子 (如 "好。") 和下一句合在一起，避免每句都付出一次 TTS 的固定开销
+SENTENCE_ENDS = "。！？!?；;\n"
+MIN_SENTENCE_CHARS = 6
+
+
+def reply_frame(kind, payload):
+    return kind + struct.pack("<I", len(payload)) + payload
+
+
+def audio_frames(wav_bytes):
+    for i in range(0, len(wav_bytes), REPLY_AUDIO_CHUNK):
+        yield reply_frame(b"A", wav_bytes[i:i + REPLY_AUDIO_CHUNK])
+
+
+def split_sentences(tokens):
+    """把 LLM 的 token 流切成句子 (生成器)"""
+    buf = ""
+    for token in tokens:
+        for ch in token:
+            buf += ch
+            if ch in SENTENCE_ENDS and len(buf.strip()) >= MIN_SENTENCE_CHARS:
+                yield buf.strip()
+                buf = ""
+    if buf.strip():
+        yield buf.strip()
+
+
+def pipelined_reply(meta, tokens, synthesize):
+    """响应体生成器：tokens 是 LLM 的输出流，synthesize(句子) 返回这一句的 WAV 字节"""
+    sentences = queue.Queue()
+
+    def produce():
+        # LLM 在后台线程里继续生成，和前面句子的 TTS 同时进行
+        try:
+            for sentence in split_sentences(tokens):
+                sentences.put(sentence)
+        except Exception as e:
+            print(f"❌ [LLM Error]: {e}")
+            sentences.put("抱歉，我的大脑连接暂时断开了。")
+        sentences.put(None)
+
+    threading.Thread(target=produce, daemon=True).start()
+
+    yield REPLY_MAGIC + reply_frame(b"J", json.dumps(meta, ensure_ascii=False).encode("utf-8"))
+    t0 = time.time()
+    index = 0
+    while True:
+        sentence = sentences.get()
+        if sentence is None:
+            break
+        index += 1
+        try:
+            wav = synthesize(sentence)
+        except Exception as e:
+            print(f"❌ [TTS Error]: {e}")
+            continue
+        print(f"   [Pipeline] clip {index} at {(time.time() - t0) * 1000:.0f} ms: {sentence}")
+        yield reply_frame(b"C", sentence.encode("utf-8"))
+        yield from audio_frames(wav)
+    yield reply_frame(b"E", b"")
+
+
+# --- 本地调试用的桩实现 ---
+
+STUB_REPLY = "你好，我是本地调试用的桩回复。第一句合成好就会先发出去！后面的句子接着合成，设备那边不停地播放。最后一句。"
+
+
+def stub_llm(text, reply=STUB_REPLY, token_delay=0.03):
+    """逐字吐出固定回复，模拟 LLM 的流式输出"""
+    for ch in reply:
+        time.sleep(token_delay)
+        yield ch
+
+
+def stub_tts(sentence, rate=16000, ms_per_char=120, delay=0.2):
+    """每句生成一段正弦音 (时长跟字数成正比)，delay 模拟合成耗时"""
+    time.sleep(delay)
+    n = rate * ms_per_char * len(sentence) // 1000
+    freq = 300 + 40 * (len(sentence) % 10)
+    pcm = struct.pack("<%dh" % n, *(int(8000 * math.sin(2 * math.pi * freq * i / rate)) for i in range(n)))
+    header = struct.pack("<4sI4s4sIHHIIHH4sI", b"RIFF", 36 + len(pcm), b"WAVE", b"fmt ", 16, 1, 1,
+                         rate, rate * 2, 2, 16, b"data", len(pcm))
+    return header + pcm
+
+
+def serve_stub(port=5000):
+    """只依赖标准库的桩服务器：/chat、/chat_stream 收下音频 (不识别)，按句流水线回复"""
+    import http.server
+    import socketserver
+
+    class Handler(http.server.BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"
+
+        def read_body(self):
+            if "chunked" in self.headers.get("Transfer-Encoding", ""):
+                while True:
+                    size = int(self.rfile.readline().strip(), 16)
+                    if size == 0:
+                        self.rfile.readline()
+                        return
+                    self.rfile.read(size)
+                    self.rfile.readline()
+            else:
+                self.rfile.read(int(self.headers.get("Content-Length", 0)))
+
+        def do_HEAD(self):
+            self.send_response(200)
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+
+        def do_POST(self):
+            self.read_body()
+            meta = {"text": "", "user_text": "(stub)", "audio_url": "", "should_end_session": False,
+                    "options": {"codec": "wav", "pipeline": "sentences"}}
+            self.send_response(200)
+            self.send_header("Content-Type", "application/x-chat-frames")
+            self.send_header("Transfer-Encoding", "chunked")
+            self.end_headers()
+            for part in pipelined_reply(meta, stub_llm(""), stub_tts):
+                self.wfile.write(b"%x\r\n%s\r\n" % (len(part), part))
+                self.wfile.flush()
+            self.wfile.write(b"0\r\n\r\n")
+
+    class Server(socketserver.ThreadingMixIn, http.server.HTTPServer):
+        daemon_threads = True
+
+    print(f">>> [Stub] Pipelined reply server on port {port}")
+    Server(("0.0.0.0", port), Handler).serve_forever()
+
+
+if __name__ == "__main__":
+    serve_stub()
@@ -1,10 +1,18 @@
 import os
 import asyncio
+import wave
+import json
+import struct
+import time
+import subprocess
 import edge_tts
-from flask import Flask, request, jsonify, send_file
+from flask import Flask, request, jsonify, send_file, Response
+from werkzeug.serving import WSGIRequestHandler
 import whisper
 from openai import OpenAI
 from dotenv import load_dotenv
+import upload_codec
+from reply_pipeline import REPLY_MAGIC, reply_frame, audio_frames, pipelined_reply
 
 # 1. 加载环境变量
 load_dotenv()
@@ -67,22 +75,53 @@ def ask_deepseek(text):
             stream=False
         )
         reply = response.choices[0].message.content
-        
-        # 2. 更新历史记录
-        chat_history.append({"role": "user", "content": text})
-        chat_history.append({"role": "assistant", "content": reply})
-        
-        # 3. 保持记忆在限制范围内 (FIFO)
-        if len(chat_history) > MAX_HISTORY_TURNS * 2:
-            # 切片保留最后 N 条
-            chat_history = chat_history[-(MAX_HISTORY_TURNS * 2):]
-
+        remember_turn(text, reply)
         return reply
     except Exception as e:
         print(f"❌ [LLM Error]: {e}")
         return "抱歉，我的大脑连接暂时断开了。"
 
-async def generate_tts_wav(text, output_wav_file):
+def remember_turn(text, reply):
+    global chat_history
+    # 2. 更新历史记录
+    chat_history.append({"role": "user", "content": text})
+    chat_history.append({"role": "assistant", "content": reply})
+    
+    # 3. 保持记忆在限制范围内 (FIFO)
+    if len(chat_history) > MAX_HISTORY_TURNS * 2:
+        # 切片保留最后 N 条
+        chat_history = chat_history[-(MAX_HISTORY_TURNS * 2):]
+
+def ask_deepseek_stream(text):
+    """流式调用 DeepSeek，逐个产出 token (按句流水线用)；出错时抛异常，由流水线换成兜底回复"""
+    print(f"   [Thinking] User asked: {text}")
+    messages = [SYSTEM_PROMPT] + chat_history + [{"role": "user", "content": text}]
+    response = client.chat.completions.create(
+        model="deepseek-chat",
+        messages=messages,
+        stream=True
+    )
+    reply = ""
+    for chunk in response:
+        delta = chunk.choices[0].delta.content if chunk.choices else None
+        if delta:
+            reply += delta
+            yield delta
+    print(f"   [Reply]: {reply}")
+    remember_turn(text, reply)
+
+# 回复音频的编码：设备带 X-Reply-Codec: adpcm 时输出 IMA-ADPCM WAV (约为 PCM 的 1/4)，
+# 设备端 WavStreamParser 边收边解码；否则输出 16bit PCM WAV
+REPLY_CODECS = {
+    "wav": "pcm_s16le",
+    "adpcm": "adpcm_ima_wav",
+}
+
+def reply_codec():
+    codec = request.headers.get("X-Reply-Codec", "wav")
+    return codec if codec in REPLY_CODECS else "wav"
+
+async def generate_tts_wav(text, output_wav_file, codec="wav"):
     """生成 TTS 音频并转码"""
     mp3_file = output_wav_file.replace(".wav", ".mp3")
 
@@ -90,35 +129,57 @@ async def generate_tts_wav(text, output_wav_file):
     communicate = edge_tts.Communicate(text, "zh-CN-XiaoxiaoNeural", rate="+20%")
     await communicate.save(mp3_file)
     
-    cmd = f'ffmpeg -y -i "{mp3_file}" -acodec pcm_s16le -ar 16000 -ac 1 "{output_wav_file}" >/dev/null 2>&1'
+    cmd = f'ffmpeg -y -i "{mp3_file}" -acodec {REPLY_CODECS[codec]} -ar 16000 -ac 1 "{output_wav_file}" >/dev/null 2>&1'
     os.system(cmd)
     
     if os.path.exists(mp3_file):
         os.remove(mp3_file)
 
+async def tts_mp3_bytes(text):
+    communicate = edge_tts.Communicate(text, "zh-CN-XiaoxiaoNeural", rate="+20%")
+    mp3 = bytearray()
+    async for chunk in communicate.stream():
+        if chunk["type"] == "audio":
+            mp3 += chunk["data"]
+    return bytes(mp3)
+
+def synthesize_clip(text, codec):
+    """按句流水线：一句话合成成一段完整的 WAV (全程在内存里，不写文件)"""
+    mp3 = asyncio.run(tts_mp3_bytes(text))
+    cmd = ["ffmpeg", "-loglevel", "error", "-i", "pipe:0", "-acodec", REPLY_CODECS[codec],
+           "-ar", "16000", "-ac", "1", "-f", "wav", "pipe:1"]
+    return subprocess.run(cmd, input=mp3, stdout=subprocess.PIPE, check=True).stdout
+
+# --- 单次往返的回复格式 (设备端解析见 ChatReplyParser.h，帧格式见 reply_pipeline.py) ---
+
+def wants_framed_reply():
+    return request.headers.get("X-Reply-Format") == "framed"
+
+def wants_pipelined_reply():
+    return wants_framed_reply() and request.headers.get("X-Reply-Pipeline") == "sentences"
+
+def framed_reply(meta, wav_path):
+    """元数据和回复音频放进同一个响应，设备不用再 GET audio_url"""
+    parts = [REPLY_MAGIC, reply_frame(b"J", json.dumps(meta, ensure_ascii=False).encode("utf-8"))]
+    with open(wav_path, "rb") as f:
+        parts.extend(audio_frames(f.read()))
+    parts.append(reply_frame(b"E", b""))
+    return Response(b"".join(parts), mimetype="application/x-chat-frames")
+
 # --- Flask 路由 ---
 
-@app.route('/chat', methods=['POST'])
-def chat():
+def run_pipeline(raw_path):
+    """ASR -> 意图 -> LLM -> TTS，返回 Flask 响应 (/chat 与 /chat_stream 共用)"""
     global chat_history
-    print("\n>>> [Server] New Request -----------------")
-    
-    raw_path = os.path.join(UPLOAD_FOLDER, "raw_input.wav")
+
     clean_path = os.path.join(UPLOAD_FOLDER, "clean_input.wav")
     reply_file = os.path.join(RESPONSE_FOLDER, 'reply.wav')
-    
-    if 'audio' not in request.files:
-        return jsonify({"error": "No audio"}), 400
-    
-    file = request.files['audio']
-    file.save(raw_path)
-
-    if os.path.getsize(raw_path) == 0:
-        return jsonify({"error": "Empty audio"}), 400
 
     cmd = f'ffmpeg -y -i "{raw_path}" -ac 1 -ar 16000 "{clean_path}" >/dev/null 2>&1'
     os.system(cmd)
 
+    # 各阶段耗时随回复返回给设备 (timing 字段)
+    t0 = time.time()
     try:
         # tiny 模型对 initial_prompt 更加敏感，这行很重要
         result = asr_model.transcribe(clean_path, language='zh', initial_prompt="你好")
@@ -128,6 +189,8 @@ def chat():
         print(f"❌ [ASR Error]: {e}")
         user_text = ""
 
+    t_asr = time.time()
+
     # 退出意图检测
     should_end_session = False
     exit_keywords = ["再见", "拜拜", "退出", "退下", "闭嘴", "休息"]
@@ -142,23 +205,150 @@ def chat():
     elif not user_text or len(user_text) < 1:
         # 如果什么都没听见，不要去请求 DeepSeek (浪费时间且污染历史)
         ai_text = "我没听清。"
+    elif wants_pipelined_reply():
+        # 按句流水线：LLM 边生成边断句，每句合成好就发，不等整段回复
+        return pipelined_response(user_text, should_end_session, None, t_asr - t0)
     else:
         # 正常对话
         ai_text = ask_deepseek(user_text)
+
+    if wants_pipelined_reply():
+        # 固定回复也走同一条路，设备端只有一种处理方式
+        return pipelined_response(user_text, should_end_session, ai_text, t_asr - t0)
     
     print(f"   [Reply]: {ai_text}")
+    t_llm = time.time()
 
+    codec = reply_codec()
     try:
-        asyncio.run(generate_tts_wav(ai_text, reply_file))
+        asyncio.run(generate_tts_wav(ai_text, reply_file, codec))
     except Exception as e:
         print(f"❌ [TTS Error]: {e}")
         return jsonify({"error": "TTS failed"}), 500
 
-    return jsonify({
+    t_tts = time.time()
+    if os.path.exists(reply_file):
+        print(f"   [TTS] {codec}: {os.path.getsize(reply_file)} bytes")
+
+    meta = {
         "text": ai_text,
+        "user_text": user_text,
         "audio_url": "/get_audio/reply.wav",
-        "should_end_session": should_end_session
-    })
+        "should_end_session": should_end_session,
+        "timing": {
+            "asr_ms": round((t_asr - t0) * 1000),
+            "llm_ms": round((t_llm - t_asr) * 1000),
+            "tts_ms": round((t_tts - t_llm) * 1000),
+        },
+        # 每轮的扩展选项 (设备端按键名读取 ChatReply::options，新增选项不用改设备代码)
+        "options": {
+            "codec": codec,
+        },
+    }
+    if wants_framed_reply():
+        return framed_reply(meta, reply_file)
+    return jsonify(meta)
+
+def unsupported_codec(codec):
+    """设备收到 415 后改传 PCM (见 NetworkClient::AttachReply 的完成回调)"""
+    print(f"❌ [Upload] Unsupported codec: {codec}")
+    return jsonify({"error": "Unsupported codec", "codecs": list(upload_codec.CODECS)}), 415
+
+def open_upload_wav(path, sample_rate):
+    wav = wave.open(path, "wb")
+    wav.setnchannels(1)
+    wav.setsampwidth(2)
+    wav.setframerate(sample_rate)
+    return wav
+
+def pipelined_response(user_text, should_end_session, fixed_text, asr_seconds):
+    """按句流水线的响应：元数据先发 (文字随每一句的 'C' 记录到达)，音频一句一段"""
+    codec = reply_codec()
+    meta = {
+        "text": "",
+        "user_text": user_text,
+        "audio_url": "",
+        "should_end_session": should_end_session,
+        "timing": {"asr_ms": round(asr_seconds * 1000)},
+        "options": {"codec": codec, "pipeline": "sentences"},
+    }
+    tokens = iter([fixed_text]) if fixed_text is not None else ask_deepseek_stream(user_text)
+    body = pipelined_reply(meta, tokens, lambda sentence: synthesize_clip(sentence, codec))
+    return Response(body, mimetype="application/x-chat-frames")
+
+@app.route('/chat', methods=['POST'])
+def chat():
+    print("\n>>> [Server] New Request -----------------")
+    
+    raw_path = os.path.join(UPLOAD_FOLDER, "raw_input.wav")
+    
+    if 'audio' not in request.files:
+        return jsonify({"error": "No audio"}), 400
+    
+    file = request.files['audio']
+    # 设备压缩上传时带 codec 字段 (见 upload_codec.py)，没有这个字段的是完整的 WAV 文件
+    codec = request.form.get("codec", "pcm")
+    if codec == "pcm":
+        file.save(raw_path)
+    elif codec in upload_codec.CODECS:
+        data = file.read()
+        try:
+            pcm = upload_codec.decode(codec, data)
+        except upload_codec.CodecError as e:
+            print(f"❌ [Upload] Bad {codec} data: {e}")
+            return jsonify({"error": "Bad audio data"}), 400
+        print(f"   [Upload] {codec}: {len(data)} bytes -> {len(pcm)} bytes PCM")
+        with open_upload_wav(raw_path, int(request.form.get("sample_rate", 16000))) as wav:
+            wav.writeframes(pcm)
+    else:
+        return unsupported_codec(codec)
+
+    if os.path.getsize(raw_path) == 0:
+        return jsonify({"error": "Empty audio"}), 400
+
+    return run_pipeline(raw_path)
+
+@app.route('/chat_stream', methods=['POST'])
+def chat_stream():
+    """边说边传：请求体是分块传输的 16bit 单声道 PCM (可能经过压缩，见 X-Audio-Codec)，设备说完时这里已经收到全部音频"""
+    print("\n>>> [Server] New Stream -----------------")
+
+    raw_path = os.path.join(UPLOAD_FOLDER, "raw_input.wav")
+    sample_rate = int(request.headers.get("X-Sample-Rate", 16000))
+    codec = request.headers.get("X-Audio-Codec", "pcm")
+    try:
+        decoder = upload_codec.StreamDecoder(codec)
+    except upload_codec.CodecError:
+        return unsupported_codec(codec)
+
+    # 边收边解码边写，不等整段请求体到齐 (Werkzeug >= 1.0 的开发服务器会自动解分块)
+    received = 0
+    decoded = 0
+    try:
+        with open_upload_wav(raw_path, sample_rate) as wav:
+            while True:
+                chunk = request.stream.read(4096)
+                if not chunk:
+                    break
+                received += len(chunk)
+                pcm = decoder.feed(chunk)
+                wav.writeframes(pcm)
+                decoded += len(pcm)
+            decoder.finish()
+    except upload_codec.CodecError as e:
+        print(f"❌ [Stream] Bad {codec} data: {e}")
+        return jsonify({"error": "Bad audio data"}), 400
+
+    print(f"   [Stream] Received {received} bytes ({codec}, {decoded} bytes PCM)")
+    if decoded == 0:
+        return jsonify({"error": "Empty audio"}), 400
+
+    return run_pipeline(raw_path)
+
+@app.route('/ping', methods=['GET', 'HEAD'])
+def ping():
+    """设备唤醒时的预连接 (HEAD)，只为建好 keep-alive 连接"""
+    return "pong"
 
 @app.route('/get_audio/<filename>', methods=['GET'])
 def get_audio(filename):
@@ -169,4 +359,6 @@ def get_audio(filename):
         return "File not found", 404
 
 if __name__ == '__main__':
-    app.run(host='0.0.0.0', port=5000)
\ No newline at end of file
+    # 默认的 HTTP/1.0 每个请求后都断开连接；改成 HTTP/1.1 后设备可以复用同一条连接
+    WSGIRequestHandler.protocol_version = "HTTP/1.1"
+    app.run(host='0.0.0.0', port=5000, threaded=True)
\ No newline at end of file
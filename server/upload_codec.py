@@ -0,0 +1,142 @@
+"""上传音频的解码 (设备端编码器见 src/services/audio/AudioEncoder.h，两边的格式必须一致)
+
+码流 = 若干包 { 样本数(2, 小端) | 负载字节数(2, 小端) | 负载 }
+- "adpcm": IMA-ADPCM，负载 = 预测值(2) + 步长索引(1) + 保留(1) + 每样本 4bit (低半字节在前)
+- "lpc":   LPC + Rice 无损，负载 = 阶数(1) + 量化位数(1) + 系数(2 x 阶数) + 每 256 样本一段的 Rice 码
+- "pcm":   不压缩 (16bit 单声道小端)
+"""
+import struct
+
+CODECS = ("pcm", "adpcm", "lpc")
+
+LPC_ORDER = 8
+RICE_PARTITION = 256
+RICE_ESCAPE = 24
+RICE_RAW_BITS = 17
+
+IMA_STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+]
+IMA_INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8]
+
+
+class CodecError(ValueError):
+    pass
+
+
+def decode_adpcm_block(count, payload, out):
+    if len(payload) < 4 + (count + 1) // 2:
+        raise CodecError("short adpcm block")
+    predictor, index = struct.unpack_from("<hB", payload, 0)
+    if index > 88:
+        raise CodecError("bad adpcm step index")
+    for i in range(count):
+        byte = payload[4 + i // 2]
+        code = (byte >> 4) if (i & 1) else (byte & 0x0F)
+        step = IMA_STEP_TABLE[index]
+        vpdiff = step >> 3
+        if code & 4:
+            vpdiff += step
+        if code & 2:
+            vpdiff += step >> 1
+        if code & 1:
+            vpdiff += step >> 2
+        predictor += -vpdiff if (code & 8) else vpdiff
+        predictor = max(-32768, min(32767, predictor))
+        index = max(0, min(88, index + IMA_INDEX_TABLE[code & 7]))
+        out.append(predictor)
+
+
+def decode_lpc_block(count, payload, history, out):
+    """history: 最近的样本在最后 (跨块延续)"""
+    if len(payload) < 2:
+        raise CodecError("short lpc block")
+    order, shift = payload[0], payload[1]
+    if order > LPC_ORDER or len(payload) < 2 + 2 * order:
+        raise CodecError("bad lpc header")
+    coefs = list(struct.unpack_from("<%dh" % order, payload, 2))
+    # 比特流转成 '0'/'1' 字符串，一元码用 str.find 找结尾的 0，比逐位读快得多
+    bits = "".join(format(b, "08b") for b in payload[2 + 2 * order:])
+    pos = 0
+    residual = []
+    try:
+        for start in range(0, count, RICE_PARTITION):
+            n = min(RICE_PARTITION, count - start)
+            k = int(bits[pos:pos + 5], 2)
+            pos += 5
+            for _ in range(n):
+                end = bits.find("0", pos, pos + RICE_ESCAPE)
+                if end < 0:
+                    pos += RICE_ESCAPE
+                    u = int(bits[pos:pos + RICE_RAW_BITS], 2)
+                    pos += RICE_RAW_BITS
+                else:
+                    high = end - pos
+                    pos = end + 1
+                    low = int(bits[pos:pos + k], 2) if k else 0
+                    pos += k
+                    u = (high << k) | low
+                residual.append((u >> 1) if not (u & 1) else -((u + 1) >> 1))
+    except ValueError:
+        # int('') : 比特流提前结束
+        raise CodecError("truncated rice data")
+
+    for r in residual:
+        acc = 0
+        for i in range(order):
+            acc += coefs[i] * history[-1 - i]
+        pred = max(-32768, min(32767, acc >> shift))
+        sample = r + pred
+        if sample < -32768 or sample > 32767:
+            raise CodecError("sample out of range")
+        history.append(sample)
+        out.append(sample)
+    del history[:-LPC_ORDER]
+
+
+class StreamDecoder:
+    """边收边解码：请求体按任意大小的块喂进来，凑齐一个包就解出来"""
+
+    def __init__(self, codec):
+        if codec not in CODECS:
+            raise CodecError("unsupported codec: %s" % codec)
+        self.codec = codec
+        self.buf = bytearray()
+        self.history = [0] * LPC_ORDER
+
+    def feed(self, data):
+        """返回这一块里能解出来的 PCM (bytes，可能为空)"""
+        if self.codec == "pcm":
+            return bytes(data)
+        self.buf += data
+        samples = []
+        pos = 0
+        while len(self.buf) - pos >= 4:
+            count, size = struct.unpack_from("<HH", self.buf, pos)
+            if len(self.buf) - pos - 4 < size:
+                break
+            payload = bytes(self.buf[pos + 4:pos + 4 + size])
+            if self.codec == "adpcm":
+                decode_adpcm_block(count, payload, samples)
+            else:
+                decode_lpc_block(count, payload, self.history, samples)
+            pos += 4 + size
+        del self.buf[:pos]
+        return struct.pack("<%dh" % len(samples), *samples)
+
+    def finish(self):
+        """码流结束时还有半个包，说明数据不完整"""
+        if self.buf:
+            raise CodecError("truncated packet")
+
+
+def decode(codec, data):
+    """解码整段上传，返回 16bit 单声道 PCM (bytes)；格式不对时抛 CodecError"""
+    decoder = StreamDecoder(codec)
+    pcm = decoder.feed(data)
+    decoder.finish()
+    return pcm
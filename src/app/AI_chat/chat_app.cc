@@ -2,8 +2,10 @@
 #include <iostream>
 #include <unistd.h> 
 
-// 注意：现在入口状态变成了 Listening，而不是 Idle
-#include "states/listening_state.h" 
+#include "states/idle_state.h"
+#include "states/listening_state.h"
+#include "states/thinking_state.h"
+#include "states/speaking_state.h"
 
 ChatApp::ChatApp() : is_running_(false), current_state_(nullptr) {}
 
@@ -16,30 +18,39 @@ void ChatApp::Init() {
 
     // 1. 启动音频服务后台线程
     // AudioProcess 是单例，Start 可以多次调用(内部有判断)，确保它是运行的
+    AudioProcess::GetInstance().Init();
     if (AudioProcess::GetInstance().Start()) {
         std::cout << "✅ [ChatApp] Audio Service Ready." << std::endl;
     } else {
         std::cerr << "❌ [ChatApp] ERROR: Failed to start Audio Service!" << std::endl;
     }
 
+    // 2. 所有状态只建这一次，会话中切换状态不再分配/释放内存
+    states_[(int)StateId::kIdle].reset(new IdleState());
+    states_[(int)StateId::kListening].reset(new ListeningState());
+    states_[(int)StateId::kThinking].reset(new ThinkingState());
+    states_[(int)StateId::kSpeaking].reset(new SpeakingState());
+
     // 注意：Init 结束后，is_running_ 依然是 false，状态依然是 nullptr
     // 我们在等待 main 函数检测到唤醒词后调用 Start()
 }
 
-void ChatApp::Start() {
+void ChatApp::Start(uint64_t wake_time_us) {
     if (is_running_) return; // 防止重复启动
 
     std::cout << ">>> [ChatApp] Starting Session..." << std::endl;
     
     // 1. 重置上下文标志位
     ctx_.should_exit = false;
+    ctx_.wake_time_us = wake_time_us;
 
     // 2. 播放开机/唤醒音效 (使用 AudioProcess，不要用 system)
     // 假设你有一个简短的 'du.wav' 或 'hi.wav'
     // AudioProcess::GetInstance().PlayWavFile("assets/sounds/greeting.wav");
 
     // 3. 直接进入监听状态 (因为是在 main 里被唤醒的)
-    ChangeState(new ListeningState());
+    // 注意：入口状态是 Listening，而不是 Idle
+    ChangeState(StateId::kListening);
 
     is_running_ = true;
 }
@@ -47,13 +58,18 @@ void ChatApp::Start() {
 void ChatApp::Stop() {
     std::cout << "<<< [ChatApp] Stopping Session..." << std::endl;
     
-    // 清理当前状态
+    // 离开当前状态 (状态对象留着下次会话复用)
     if (current_state_) {
         current_state_->Exit(&ctx_);
-        delete current_state_;
         current_state_ = nullptr;
     }
 
+    // 会话中途结束时可能还有没取结果的流式上传，直接放弃
+    ctx_.network->StreamAbort();
+
+    // 会话结束时打印各录音游标的积压/丢帧情况，方便排查卡顿
+    AudioProcess::GetInstance().LogTapStats();
+
     is_running_ = false;
 }
 
@@ -61,47 +77,39 @@ void ChatApp::RunOnce() {
     // 如果没运行，直接返回
     if (!is_running_) return;
 
-    // 1. 检查是否有强制退出标志 (来自 NetworkClient 解析到的 "再见")
-    if (ctx_.should_exit) {
-        std::cout << "✅ [ChatApp] Exit flag detected. Closing app." << std::endl;
-        Stop();
-        return;
-    }
-
-    // 2. 安全检查
+    // 1. 安全检查
+    // ("再见" 的 should_exit 不在这里处理：元数据比音频先到，这里一停回复就播不出来了；
+    //  由 SpeakingState 播完之后返回 Finish 结束会话)
     if (!current_state_) {
         // 如果运行中状态却为空，说明出错了，强制停止
         Stop();
         return;
     }
 
-    // 3. 状态机流转
-    StateBase* next_state = current_state_->Update(&ctx_);
-
-    // 如果状态发生了变化
-    if (next_state != current_state_) {
-        // 这里的逻辑很关键：
-        // 如果 next_state 是 nullptr，说明 SpeakingState 觉得聊完了，返回了空
-        // ChangeState 会处理 nullptr (删除 current，置空)
-        ChangeState(next_state);
-        
-        // 再次检查，如果切到了空状态，说明 App 该结束了
-        if (current_state_ == nullptr) {
+    // 2. 状态机流转
+    Transition next = current_state_->Update(&ctx_);
+
+    switch (next.kind) {
+        case Transition::kStay:
+            break;
+        case Transition::kGo:
+            ChangeState(next.next);
+            break;
+        case Transition::kFinish:
+            // SpeakingState 觉得聊完了
             std::cout << "✅ [ChatApp] Conversation finished normally." << std::endl;
             Stop();
-        }
+            break;
     }
 }
 
-void ChatApp::ChangeState(StateBase* new_state) {
-    // 即使 new_state 是 nullptr，我们也需要执行清理旧状态的逻辑
+void ChatApp::ChangeState(StateId id) {
     if (current_state_) {
         current_state_->Exit(&ctx_);
-        delete current_state_;
     }
-    
-    current_state_ = new_state;
-    
+
+    current_state_ = states_[(int)id].get();
+
     if (current_state_) {
         current_state_->Enter(&ctx_);
     }
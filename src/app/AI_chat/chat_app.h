@@ -13,7 +13,8 @@ public:
     void Init();
 
     // [新增] 启动 App (当 main 检测到唤醒词时调用)
-    void Start();
+    // wake_time_us: 唤醒词结束的时刻 (AudioProcess 时间轴)，录音会从它之前一点开始
+    void Start(uint64_t wake_time_us = 0);
 
     // [新增] 停止 App (内部调用，或者强制退出时调用)
     void Stop();
@@ -27,13 +28,16 @@ public:
 private:
     bool is_running_ = false; // 标志位
 
-    // 内部切换状态的辅助函数
-    void ChangeState(StateBase* new_state);
+    // 内部切换状态的辅助函数 (Exit 当前状态，Enter 新状态)
+    void ChangeState(StateId id);
 
     // 上下文
     ChatContext ctx_;
 
-    // 当前状态
+    // 所有状态在 Init 时各建一个，之后只在它们之间切换
+    std::unique_ptr<StateBase> states_[(int)StateId::kCount];
+
+    // 当前状态 (指向 states_ 里的一个，不拥有)
     StateBase* current_state_;
 };
 
@@ -3,10 +3,13 @@
 
 #include <memory>
 #include <string>
+#include <cstdint>
 
 // 引入你的服务 (根据你的实际路径调整)
 #include "../../services/audio/AudioProcess.h"
 #include "../../services/network/NetworkClient.h"
+#include "../../services/network/ChatReplyParser.h"
+#include "../../services/network/ChatReply.h"
 
 // 前置声明，防止循环引用
 class ChatApp;
@@ -21,6 +24,23 @@ struct ChatContext {
     std::string last_user_text;   // 刚刚识别到的用户语音文字
     std::string last_ai_reply;    // AI 返回的回复文字
 
+    // 唤醒词结束的时刻 (AudioProcess 时间轴，微秒)，0 表示不是刚被唤醒
+    // ListeningState 据此从录音历史中回看 WAKE_PREROLL_MS，用完即清零
+    uint64_t wake_time_us = 0;
+
+    // 本轮用户说完的时刻 (最后一个语音帧的结束，AudioProcess 时间轴)，0 表示没检测到说话
+    // ListeningState 写入；ThinkingState 在流式上传的结束块发出后 (或整段上传开始时) 打印 "说完 -> 上传" 的延迟
+    uint64_t speech_end_us = 0;
+
+    // 本轮回复的元数据 (ThinkingState 解析一次，每轮复用)，扩展选项见 reply.options
+    ChatReply reply;
+    // 单次往返模式下本轮回复的解析器 (网络线程写，主循环读元数据)
+    ChatReplyParser reply_stream;
+
+    // ThinkingState 交给 SpeakingState 的结果 (状态对象是复用的，参数不再走构造函数)
+    bool reply_has_audio = false;      // 有没有拿到回复音频
+    bool reply_already_playing = false; // 回复已经通过边下边播送进播放队列，不用再播放文件
+
     // 构造函数初始化
     ChatContext() {
         audio = &AudioProcess::GetInstance();
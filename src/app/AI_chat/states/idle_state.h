@@ -2,26 +2,23 @@
 #define IDLE_STATE_H
 
 #include "state_base.h"
-#include "snowboy/snowboy-detect.h"
-#include <memory>           // 引用智能指针
+#include <vector>
 
+// App 层的唤醒检测：和桌面待机 (main) 共用同一个 WakeWordEngine，不再自己加载 Snowboy 模型
 class IdleState : public StateBase {
 public:
-    // 构造函数：我们可以在这里就加载模型，或者在 Init 中加载
-    IdleState(); 
+    IdleState() = default;
     virtual ~IdleState() = default;
 
     void Enter(ChatContext* ctx) override;
-    StateBase* Update(ChatContext* ctx) override;
+    Transition Update(ChatContext* ctx) override;
     void Exit(ChatContext* ctx) override;
     std::string Name() const override { return "Idle"; }
 
 private:
-    // 使用智能指针管理 Snowboy 对象，自动释放内存
-    std::unique_ptr<snowboy::SnowboyDetect> detector_;
-    
-    // 标记是否已经初始化成功
-    bool is_detector_initialized_ = false;
+    // 本状态专属的录音游标 (Enter 订阅，Exit 释放)
+    CaptureTap* tap_ = nullptr;
+    std::vector<int16_t> scratch_;  // 视图跨过环形缓冲区回绕点时拼接用
 };
 
-#endif
\ No newline at end of file
+#endif
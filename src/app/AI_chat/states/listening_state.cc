@@ -1,91 +1,146 @@
 #include "states/listening_state.h"
-#include "states/thinking_state.h"
 #include "services/audio/AudioProcess.h"
+#include "common/config.h"
 
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
 #include <unistd.h> // for sleep/usleep
 #include <stdlib.h> // for system
 
-// 定义文件名
-#define RECORD_FILE "user_input.wav"
 #define WAKE_REPLY_SOUND "assets/hm.wav"
 
-// VAD 阈值 (需要根据实际麦克风调整，通常 1000-3000)
-#define VAD_THRESHOLD 2000 
-// 静音判定 (30帧 * 64ms ≈ 2秒)
-#define MAX_SILENCE_FRAMES 30
-// 最大录音时长 (150帧 * 64ms ≈ 10秒)
-#define MAX_RECORD_FRAMES 150
-
 // 构造函数：初始化状态变量
-ListeningState::ListeningState() 
-    : silence_counter_(0), total_frames_(0), has_speech_started_(false) {}
+ListeningState::ListeningState() {}
 
 void ListeningState::Enter(ChatContext* ctx) {
-    //hm？
-    AudioProcess::GetInstance().PlayWavFile(WAKE_REPLY_SOUND);
-    // 使用新的 IsPlaying 接口轮询，看hm音效播放完没
-    while (AudioProcess::GetInstance().IsPlaying()) {
-        usleep(10000); 
+    // 状态对象是复用的，每一轮重新判定
+    endpointer_.Reset();
+    ctx->speech_end_us = 0;
+
+    // 刚被唤醒时，从唤醒词结束前 WAKE_PREROLL_MS 开始录音；多轮对话的后续轮次从现在开始
+    uint64_t start_us = 0;
+    if (ctx->wake_time_us) {
+        start_us = ctx->wake_time_us - WAKE_PREROLL_MS * 1000ULL;
+        ctx->wake_time_us = 0;
     }
 
     //开始录音
     std::cout << ">>> [State] LISTENING: Start Recording..." << std::endl;
-    AudioProcess::GetInstance().ClearBuff();
-    AudioProcess::GetInstance().SaveStart(RECORD_FILE);
+    // VAD 订阅自己的游标，和内存录音对齐到同一个起点
+    // 跳长取 VAD 帧 (10ms)，说完的判定不再以一个 ALSA 周期为粒度
+    tap_ = AudioProcess::GetInstance().Subscribe("vad", VAD_FRAME_SAMPLES);
+    if (tap_ && start_us) tap_->SeekToTime(start_us);
+    // 录进内存，ThinkingState 直接从内存上传，不经过 SD 卡
+    AudioProcess::GetInstance().UtteranceStart(start_us);
+
+    //hm？ (不阻塞等它播完：pre-roll 照常保留，只跳过提示音播放期间的录音，
+    // 否则喇叭里的 "嗯?" 会被麦克风录进去，既可能触发说话判定，也会被当成用户的话上传)
+    prompt_pos_ = AudioProcess::GetInstance().CapturePos();
+    AudioProcess::GetInstance().RecordHold(prompt_pos_);
+    prompting_ = true;
+    resume_us_ = 0;
+    AudioProcess::GetInstance().PlayWavFile(WAKE_REPLY_SOUND);
+
+#if CHAT_STREAM_UPLOAD
+    // 边说边传：VAD 游标读到的每一帧同时发给服务器 (连接也在这时建好)
+    ChatReplyParser* reply = nullptr;
+#if CHAT_INLINE_REPLY
+    // 回复音频就在这个请求的响应里，解析出来直接进播放队列
+    ctx->reply_stream.Reset(AudioProcess::PlayStreamSink, AudioProcess::PlayStreamFinish, ctx->audio,
+                            AudioProcess::PlayStreamClip);
+    reply = &ctx->reply_stream;
+#endif
+    ctx->network->StreamBegin(CHAT_STREAM_ENDPOINT, 16000, reply);
+#else
+    // 用户说话的同时把连接建好，说完后的上传直接复用
+    ctx->network->Prewarm();
+#endif
 }
 
-StateBase* ListeningState::Update(ChatContext* ctx) {
-    std::vector<int16_t> frame_data;
-
-    // 尝试获取一帧音频
-    if (AudioProcess::GetInstance().GetFrame(frame_data)) {
-        double rms = AudioProcess::CalculateRMS(frame_data);
-        // 调试 VAD 阈值时可以解开这行
-        // printf("RMS: %.0f\n", rms);
-        if (rms > VAD_THRESHOLD) {
-            // 检测到说话
-            if (!has_speech_started_) {
-                std::cout << "   (Speech Started...)" << std::endl;
-            }
-            has_speech_started_ = true;
-            silence_counter_ = 0; // 重置静音计数
-        } else {
-            // 静音
-            if (has_speech_started_) {
-                silence_counter_++;
-            }
-        }
+bool ListeningState::PromptFinished() {
+    AudioProcess& audio = AudioProcess::GetInstance();
+    if (!resume_us_) {
+        if (audio.IsPlaying()) return false;
+        // 队列空了，硬件缓冲区里最多还有一整个缓冲区没从喇叭出来，再加上余量
+        resume_us_ = AudioProcess::NowUs() + audio.PlaybackBufferSize() * 1000000ULL / 16000
+                     + LISTEN_PROMPT_GUARD_MS * 1000ULL;
+    }
+    return AudioProcess::NowUs() >= resume_us_;
+}
 
-        total_frames_++;
+Transition ListeningState::Update(ChatContext* ctx) {
+    AudioProcess& audio = AudioProcess::GetInstance();
+    if (prompting_ && PromptFinished()) {
+        // 提示音这一段两边都跳过，从播完的位置接着录
+        uint64_t pos = audio.PosAtTime(resume_us_);
+        if (tap_) tap_->Seek(std::max(pos, tap_->Position()));
+        audio.RecordResume(pos);
+        prompting_ = false;
+        printf("[Listen] skipped %llu ms of prompt playback\n",
+               (unsigned long long)(pos > prompt_pos_ ? (pos - prompt_pos_) * 1000 / 16000 : 0));
+    }
 
-        // 判定退出条件
-        // 条件 A: 说完话了 (开始过说话 + 连续静音2秒)
-        if (has_speech_started_ && silence_counter_ > MAX_SILENCE_FRAMES) {
-            std::cout << "✅ [VAD] Speech End Detected." << std::endl;
-            return new ThinkingState();
+    // 把已经到的数据一帧一帧处理完 (一个 ALSA 周期里有好几个 VAD 帧)；直接读环形缓冲区里的视图，不拷贝
+    CaptureView frame;
+    while (tap_) {
+        size_t n = tap_->Hop();
+        if (prompting_) {
+            // 提示音开始之前的 pre-roll 照常处理，之后的等播完再说
+            uint64_t pos = tap_->Position();
+            if (pos >= prompt_pos_) break;
+            n = (size_t)std::min<uint64_t>(n, prompt_pos_ - pos);
         }
+        if (!tap_->Peek(n, frame)) break;
+        if (ctx->network->StreamActive()) {
+            for (int i = 0; i < 2; i++) {
+                if (frame.len[i]) ctx->network->StreamWrite(frame.part[i], frame.len[i] * sizeof(int16_t));
+            }
+        }
+        tap_->Consume(frame);
 
-        // 条件 B: 超时 (录太久了)
-        if (total_frames_ > MAX_RECORD_FRAMES) {
-            std::cout << "[VAD] Timeout." << std::endl;
-            return new ThinkingState();
+        // 录音线程已经对这一帧跑过自适应 VAD (相对噪声底判断，带迟滞)，按录音位置取结果
+        VadResult vad;
+        audio.VadQuery(frame.pos, frame.EndPos(), vad);
+        // 调试 VAD 时可以解开这行
+        // printf("VAD: p=%u snr=%ddB floor=%d/%ddBFS\n", vad.prob, vad.snr_db,
+        //        AudioProcess::GetInstance().Vad().NoiseFloorDb(0), AudioProcess::GetInstance().Vad().NoiseFloorDb(1));
+
+        bool was_started = endpointer_.SpeechStarted();
+        Endpointer::Decision decision = endpointer_.Feed(vad, frame.Size(), frame.EndPos());
+        if (!was_started && endpointer_.SpeechStarted()) {
+            std::cout << "   (Speech Started...)" << std::endl;
         }
+        if (decision == Endpointer::kContinue) continue;
 
-        // 条件 C: 一直没说话 (5秒全是静音)
-        if (!has_speech_started_ && total_frames_ > 80) { // 约 5秒
-             std::cout << "[VAD] No speech detected." << std::endl;
-             // 可以选择重试，或者直接去 Thinking 让 Server 处理空录音
-             return new ThinkingState();
+        // 说完了 / 超时 / 一直没说话 (可以选择重试，这里直接去 Thinking 让 Server 处理空录音)
+        std::cout << "[VAD] " << Endpointer::DecisionName(decision) << ": speech " << endpointer_.SpeechMs()
+                  << " ms, " << endpointer_.Pauses() << " pauses (max " << endpointer_.MaxPauseMs()
+                  << " ms), hangover " << endpointer_.HangoverMs() << " ms" << std::endl;
+        if (endpointer_.SpeechStarted()) {
+            ctx->speech_end_us = audio.TimeAtPos(endpointer_.SpeechEndPos());
         }
+        return Transition::Go(StateId::kThinking);
     }
 
     // 继续录音
-    return this;
+    return Transition::Stay();
 }
 
 void ListeningState::Exit(ChatContext* ctx) {
     std::cout << ">>> [State] Exit LISTENING (Processing Audio)" << std::endl;
-    //停止写入文件
-    AudioProcess::GetInstance().SaveStop();
+    //停止录音 (回填内存中的 WAV 头)
+    AudioProcess::GetInstance().UtteranceStop();
+    // 发送结束块；回复由 ThinkingState 等待
+    if (ctx->network->StreamActive()) {
+#if CHAT_INLINE_REPLY
+        // 发完结束块之后回复音频随时可能到达，播放流要先准备好
+        ctx->audio->PlayStreamBegin(REPLY_PREFILL_MS);
+#endif
+        // 这里只是交给网络线程，"说完 -> 上传完成" 由 ThinkingState 等结束块真正发出后打印
+        ctx->network->StreamEnd();
+    }
+    AudioProcess::GetInstance().Unsubscribe(tap_);
+    tap_ = nullptr;
+    prompting_ = false;
 }
\ No newline at end of file
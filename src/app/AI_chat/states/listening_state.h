@@ -2,22 +2,31 @@
 #define LISTENING_STATE_H
 
 #include "states/state_base.h"
+#include "services/audio/Endpointer.h"
+#include <vector>
 
 class ListeningState : public StateBase {
 public:
-    ListeningState(); // 构造函数初始化变量
+    ListeningState(); // 每次 Enter 重置判定状态
 
     void Enter(ChatContext* ctx) override;
-    StateBase* Update(ChatContext* ctx) override;
+    Transition Update(ChatContext* ctx) override;
     void Exit(ChatContext* ctx) override;
     
     std::string Name() const override { return "Listening"; }
 
 private:
-    // VAD 状态变量
-    int silence_counter_;      // 连续静音帧数
-    int total_frames_;         // 总录制帧数
-    bool has_speech_started_;  // 是否检测到过语音
+    // 提示音播完 (含硬件缓冲区和余量) 了没有
+    bool PromptFinished();
+
+    Endpointer endpointer_;            // 说完判定 (结尾静音自适应)
+
+    // 提示音：[prompt_pos_, 播完) 这段录音被跳过，VAD 游标和内存录音都从播完的位置接着录
+    bool prompting_ = false;
+    uint64_t prompt_pos_ = 0;          // 开始播提示音时的录音位置
+    uint64_t resume_us_ = 0;           // 可以接着录的时刻，0 表示播放队列还没空
+
+    CaptureTap* tap_ = nullptr;        // VAD 专属的录音游标 (跳长 = VAD 帧)
 };
 
 #endif
\ No newline at end of file
@@ -1,28 +1,38 @@
 #include "states/speaking_state.h"
-#include "states/listening_state.h"
 #include "services/audio/AudioProcess.h"
+#include "common/config.h"
 #include <iostream>
-#include <unistd.h> // for sleep
 
 void SpeakingState::Enter(ChatContext* ctx) {
     std::cout << ">>> [State]SPEAKING" << std::endl;
+    // 这一轮失败了：reply.wav 不存在或是上一轮留下的，不播
+    if (!ctx->reply_has_audio) return;
+    // 边下边播的回复已经在播放队列里了
+    if (ctx->reply_already_playing) return;
     // 使用 AudioProcess 内部接口播放
     AudioProcess::GetInstance().PlayWavFile("reply.wav");
 }
 
-StateBase* SpeakingState::Update(ChatContext* ctx) {
-    while (AudioProcess::GetInstance().IsPlaying()) {
-            usleep(100000); // 100ms
-        }
+Transition SpeakingState::Update(ChatContext* ctx) {
+    // 还在播就下一轮再来，不阻塞主循环 (UI 和唤醒检测照常运行)
+    if (AudioProcess::GetInstance().IsPlaying()) return Transition::Stay();
+
+#if REPLY_SENTENCE_PIPELINE
+    // 按句流水线的回复文字是一句一句跟着音频来的，播完才齐
+    if (ctx->reply_stream.Clips() > 0) {
+        ctx->last_ai_reply = ctx->reply_stream.ClipText();
+        std::cout << "   (Reply): " << ctx->last_ai_reply << std::endl;
+    }
+#endif
 
     //检查是否需要退出 App
     if (ctx->should_exit) {
         std::cout << "✅ [State] 'Goodbye' detected. Ending session." << std::endl;
-        // 返回 nullptr 表示状态机结束，ChatApp::RunOnce 会捕获到并调用 Stop()
-        return nullptr; 
+        // Finish 表示状态机结束，ChatApp::RunOnce 会捕获到并调用 Stop()
+        return Transition::Finish();
     }
     std::cout << ">>> Loop back to Listening..." << std::endl;
-    return new ListeningState();
+    return Transition::Go(StateId::kListening);
 }
 
 void SpeakingState::Exit(ChatContext* ctx) {
@@ -4,14 +4,12 @@
 #include "state_base.h"
 #include <string>
 
+// 播什么由 ThinkingState 写进上下文：ctx->reply_has_audio 表示是否成功拿到了音频，
+// ctx->reply_already_playing 表示回复已经通过边下边播送进播放队列，Enter 时不用再播放文件
 class SpeakingState : public StateBase {
-    bool has_audio_;
 public:
-    // 构造函数接收一个 bool，表示是否成功下载了音频
-    SpeakingState(bool success) : has_audio_(success) {}
-    
     void Enter(ChatContext* ctx) override;
-    StateBase* Update(ChatContext* ctx) override;
+    Transition Update(ChatContext* ctx) override;
     void Exit(ChatContext* ctx) override;
     std::string Name() const override { return "Speaking"; }
 };
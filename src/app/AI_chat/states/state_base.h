@@ -5,7 +5,33 @@
 #include <memory>
 #include "../chat_context.h"
 
+// 状态编号：ChatApp 在 Init 时为每个编号建好一个状态对象，切换状态只换编号，不再 new/delete
+enum class StateId {
+    kIdle,
+    kListening,
+    kThinking,
+    kSpeaking,
+    kCount,
+};
+
+// Update 的返回值
+struct Transition {
+    enum Kind {
+        kStay,    // 留在当前状态，下一轮继续 Update
+        kGo,      // 切到 next (Exit 当前状态，Enter next；next 是自己时也会重新进入)
+        kFinish,  // 会话结束，ChatApp 调用 Stop()
+    };
+
+    Kind kind;
+    StateId next;
+
+    static Transition Stay() { return Transition{kStay, StateId::kCount}; }
+    static Transition Go(StateId id) { return Transition{kGo, id}; }
+    static Transition Finish() { return Transition{kFinish, StateId::kCount}; }
+};
+
 // 状态基类
+// 状态对象整个进程只建一次、反复进入，每一轮的变量要在 Enter 里重置，不能只靠构造函数
 class StateBase {
 public:
     virtual ~StateBase() = default;
@@ -13,8 +39,8 @@ public:
     // 当状态机进入该状态时调用 (e.g. 开始录音, 开始播放动画)
     virtual void Enter(ChatContext* ctx) = 0;
 
-    // 状态的主循环，返回“下一个状态的指针”，如果不切换则返回 nullptr
-    virtual StateBase* Update(ChatContext* ctx) = 0;
+    // 状态的主循环，返回留下 / 切换 / 结束 (见 Transition)
+    virtual Transition Update(ChatContext* ctx) = 0;
 
     // 当状态机离开该状态时调用 (e.g. 停止录音, 清理资源)
     virtual void Exit(ChatContext* ctx) = 0;
@@ -23,4 +49,4 @@ public:
     virtual std::string Name() const = 0;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,56 +1,200 @@
 #include "thinking_state.h"
+#include <cstdio>
 #include <iostream>
 #include <string>
-#include "speaking_state.h" 
+#include "common/config.h"
 
 void ThinkingState::Enter(ChatContext* ctx) {
     std::cout << ">>> [State]THINKING: Uploading" << std::endl;
+    // 状态对象是复用的，每一轮从头开始
+    phase_ = kStart;
+    uploaded_ = false;
+    json_seen_ = false;
+    request_.reset();
     // 如果有UI，这里调用 ctx->ui->ShowThinking();
 }
 
-StateBase* ThinkingState::Update(ChatContext* ctx) {
-    // 1. 设置服务器 IP
-    ctx->network->SetServerIP("192.168.137.1"); 
+Transition ThinkingState::Update(ChatContext* ctx) {
+    switch (phase_) {
+        case kStart:
+            // 1. 设置服务器 IP
+            ctx->network->SetServerIP("192.168.137.1"); 
 
-    // 2. 发送刚才录制的真实音频
-    // 这个文件是刚才 ListeningState 用 arecord 生成的
-    std::cout << "   (Uploading user_input.wav)..." << std::endl;
-    
-    bool server_wants_exit = false;
-    std::string json = ctx->network->SendAudio("user_input.wav", server_wants_exit);
-    ctx->should_exit = server_wants_exit;
+            // 2. 边说边传模式下音频已经在路上了，这里只等服务器回复
+            if (ctx->network->StreamActive()) {
+                std::cout << "   (Waiting for streamed reply)..." << std::endl;
+                request_ = ctx->network->StreamTake();
+                phase_ = kWaitReply;
+                return Transition::Stay();
+            }
+            return Upload(ctx);
 
-    // 3. 检查有没有收到回复
-    if (json.empty()) {
+        case kWaitReply: {
+            LogUploadDone(ctx);
+#if CHAT_INLINE_REPLY
+            return WaitInlineReply(ctx);
+#else
+            if (!request_->Finished()) return Transition::Stay();
+
+            bool got_reply = NetworkClient::ParseReply(*request_, ctx->reply);
+            request_.reset();
+
+            // 流式请求失败：再整段上传一次
+            if (!got_reply && !uploaded_) return Upload(ctx);
+
+            return OnReply(ctx, got_reply);
+#endif
+        }
+
+        case kDownloading: {
+            // 先取完成标志：完成回调 (PlayStreamEnd) 执行完才会置位，之后再看有没有声音就不会漏判
+            bool finished = request_->Finished();
+            // 第一段声音进了播放队列就去 Speaking，剩下的数据由网络线程继续送进播放队列
+            if (ctx->audio->PlayStreamHasAudio()) return Speak(ctx, true, true); // 已经在播了
+            if (!finished) return Transition::Stay();
+
+            std::cerr << "   (Reply stream has no audio)" << std::endl;
+            return Speak(ctx, false);
+        }
+    }
+    return Transition::Stay();
+}
+
+// 3. 没有流式请求或流式请求失败：发送刚才录制的真实音频
+// ListeningState 录在内存里 (完整的 WAV)，直接上传，不落盘
+Transition ThinkingState::Upload(ChatContext* ctx) {
+    const UtteranceBuffer& utt = ctx->audio->Utterance();
+    std::cout << "   (Uploading " << utt.WavSize() << " bytes from memory)..." << std::endl;
+#if CHAT_INLINE_REPLY
+    ctx->reply_stream.Reset(AudioProcess::PlayStreamSink, AudioProcess::PlayStreamFinish, ctx->audio,
+                            AudioProcess::PlayStreamClip);
+    ctx->audio->PlayStreamBegin(REPLY_PREFILL_MS);
+    request_ = ctx->network->SendAudioAsync(utt.WavData(), utt.WavSize(), "user_input.wav", &ctx->reply_stream);
+    if (!request_) ctx->audio->PlayStreamEnd();
+#else
+    request_ = ctx->network->SendAudioAsync(utt.WavData(), utt.WavSize(), "user_input.wav");
+#endif
+    uploaded_ = true;
+    if (!request_) return Speak(ctx, false);
+    // 整段上传模式下 "说完 -> 上传" 在这里结束 (流式上传失败后的补传不再重复统计)
+    if (ctx->speech_end_us) {
+        printf("[Latency] speech end -> upload start: %llu ms\n",
+               (unsigned long long)((AudioProcess::NowUs() - ctx->speech_end_us) / 1000));
+        ctx->speech_end_us = 0;
+    }
+
+    phase_ = kWaitReply;
+    return Transition::Stay();
+}
+
+// 流式上传的结束块发出后打印 "说完 -> 上传完成" (时刻由网络线程的读回调记录)
+void ThinkingState::LogUploadDone(ChatContext* ctx) {
+    if (!ctx->speech_end_us || !request_) return;
+    uint64_t done_us = request_->UploadEndUs();
+    if (!done_us) return;
+    long long ms = ((long long)done_us - (long long)ctx->speech_end_us) / 1000;
+    printf("[Latency] speech end -> upload done: %lld ms\n", ms);
+    ctx->speech_end_us = 0;
+}
+
+#if CHAT_INLINE_REPLY
+// 单次往返：元数据和音频在同一个响应里，元数据先到，音频紧跟着进播放队列
+Transition ThinkingState::WaitInlineReply(ChatContext* ctx) {
+    // 先取完成标志：完成回调 (PlayStreamEnd) 执行完才会置位，之后再看有没有声音就不会漏判
+    bool finished = request_->Finished();
+
+    // 元数据只解析一次
+    if (!json_seen_ && ctx->reply_stream.JsonReady()) {
+        json_seen_ = true;
+        if (NetworkClient::ParseReply(ctx->reply_stream, ctx->reply)) ApplyReply(ctx);
+    }
+
+    if (ctx->audio->PlayStreamHasAudio()) {
+        // 剩下的音频由网络线程继续送进播放队列，请求交给它自己结束，Exit 不要取消
+        request_.reset();
+        return Speak(ctx, true, true); // 已经在播了
+    }
+    if (!finished) return Transition::Stay();
+    request_.reset();
+
+    // 流式请求失败：再整段上传一次
+    if (!json_seen_ && !uploaded_) return Upload(ctx);
+
+    if (!json_seen_) {
         std::cerr << "   (Error: Server No Response)" << std::endl;
-        return new SpeakingState(false); // 失败去 Speaking 报个错
+    } else {
+        std::cerr << "   (Reply has no audio)" << std::endl;
+    }
+    return Speak(ctx, false);
+}
+#endif
+
+Transition ThinkingState::Speak(ChatContext* ctx, bool success, bool already_playing) {
+    ctx->reply_has_audio = success;
+    ctx->reply_already_playing = already_playing;
+    return Transition::Go(StateId::kSpeaking);
+}
+
+// 回复元数据写进上下文：是否结束会话、本轮的文字
+void ThinkingState::ApplyReply(ChatContext* ctx) {
+    const ChatReply& reply = ctx->reply;
+    ctx->should_exit = reply.should_end_session;
+    ctx->last_user_text = reply.user_text;
+    ctx->last_ai_reply = reply.text;
+
+    std::cout << "   (Heard): " << reply.user_text << std::endl;
+    std::cout << "   (Reply): " << reply.text << std::endl;
+    if (reply.asr_ms >= 0) {
+        std::cout << "   (Server timing: asr " << reply.asr_ms << " ms, llm " << reply.llm_ms
+                  << " ms, tts " << reply.tts_ms << " ms)" << std::endl;
     }
+}
 
-    std::cout << "   (Server Reply JSON): " << json << std::endl;
+Transition ThinkingState::OnReply(ChatContext* ctx, bool got_reply) {
+    // 4. 检查有没有收到回复
+    if (!got_reply) {
+        std::cerr << "   (Error: Server No Response)" << std::endl;
+        return Speak(ctx, false); // 失败去 Speaking 报个错
+    }
+    ApplyReply(ctx);
 
-    // 4. 解析 JSON 提取 audio_url
-    // 简单查找 "audio_url" 字段
-    std::string key = "audio_url";
-    size_t found = json.find(key);
-    
-    if (found != std::string::npos) {
-        // 我们知道 Server 总是返回 /get_audio/reply.wav
-        // 所以这里可以直接写死路径，或者你可以写复杂的 JSON 解析逻辑
-        std::string url = "/get_audio/reply.wav"; 
+    // 5. 回复音频的下载地址由服务器给出
+    if (!ctx->reply.audio_url.empty()) {
+        const std::string& url = ctx->reply.audio_url;
         
-        // 5. 下载回复音频，保存为 reply.wav
+#if REPLY_STREAM_PLAYBACK
+        // 6. 边下边播：数据一到就解析进播放队列，首个声音不再等整段下载完
+        std::cout << "   (Streaming reply)..." << std::endl;
+        AudioProcess* audio = ctx->audio;
+        audio->PlayStreamBegin(REPLY_PREFILL_MS);
+        request_ = ctx->network->DownloadStreamAsync(url, AudioProcess::PlayStreamSink, audio, [audio](NetRequest& req) {
+            // 网络线程：无论成功、失败还是取消都要结束流，否则播放线程一直等
+            if (!req.Succeeded()) std::cerr << "   (Reply stream cut short, playing what we got)" << std::endl;
+            audio->PlayStreamEnd();
+        });
+        if (request_) {
+            phase_ = kDownloading;
+            return Transition::Stay();
+        }
+        audio->PlayStreamEnd();
+#else
+        // 6. 下载回复音频，保存为 reply.wav
         std::cout << "   (Downloading reply)..." << std::endl;
         bool dl_ok = ctx->network->DownloadFile(url, "reply.wav");
         
         if (dl_ok) {
             std::cout << "   (Download Success!)" << std::endl;
-            return new SpeakingState(true); // 成功，带参数 true，去播放
+            return Speak(ctx, true); // 成功，带参数 true，去播放
         }
+#endif
     }
 
-    return new SpeakingState(false);
+    return Speak(ctx, false);
 }
 
 void ThinkingState::Exit(ChatContext* ctx) {
     std::cout << ">>> [State] Exit THINKING" << std::endl;
-}
\ No newline at end of file
+    // 会话中途结束时放弃还在等的上传；边下边播的下载交给 SpeakingState，继续播完
+    if (request_ && phase_ == kWaitReply) ctx->network->Cancel(request_);
+    request_.reset();
+}
@@ -2,13 +2,37 @@
 #define THINKING_STATE_H
 
 #include "state_base.h"
+#include "services/network/NetworkWorker.h"
 
+// 网络请求交给 NetworkWorker 在后台执行，Update 只轮询结果，主循环 (UI/唤醒) 不会被卡住
 class ThinkingState : public StateBase {
 public:
+    ThinkingState() : phase_(kStart), uploaded_(false), json_seen_(false) {}
+
     void Enter(ChatContext* ctx) override;
-    StateBase* Update(ChatContext* ctx) override;
+    Transition Update(ChatContext* ctx) override;
     void Exit(ChatContext* ctx) override;
     std::string Name() const override { return "Thinking"; }
+
+private:
+    enum Phase {
+        kStart,        // 还没发请求
+        kWaitReply,    // 等服务器的 JSON 回复 (流式上传或整段上传)；单次往返模式下音频也在这个响应里
+        kDownloading,  // 回复音频边下边播，等第一段声音进入播放队列
+    };
+
+    Transition Upload(ChatContext* ctx);
+    Transition OnReply(ChatContext* ctx, bool got_reply);
+    void ApplyReply(ChatContext* ctx);
+    Transition WaitInlineReply(ChatContext* ctx);
+    void LogUploadDone(ChatContext* ctx);
+    // 去 Speaking：success 表示拿到了回复音频，already_playing 表示它已经在播放队列里了
+    static Transition Speak(ChatContext* ctx, bool success, bool already_playing = false);
+
+    Phase phase_;
+    NetRequestPtr request_;
+    bool uploaded_;   // 已经整段上传过 (流式请求失败后只补传一次)
+    bool json_seen_;  // 单次往返模式：元数据已经处理过
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,156 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+// ==========================================
+// 音频 (AudioProcess)
+// ==========================================
+
+// ALSA 缓冲区档位 (AudioProcess::Profile): 0 = 低延迟 (录音 10ms 周期), 1 = 均衡 (20ms), 2 = 省电 (128ms)
+// 设备不接受时自动退回更大的周期；运行时可用环境变量 ECHO_AUDIO_PROFILE=low/balanced/power 覆盖
+#define AUDIO_PROFILE 1
+
+// 录音/播放走 tinyalsa 的 mmap 接口 (1) 还是 pcm_read/pcm_write (0)
+// mmap 直接在 DMA 缓冲区上合成/写入，省掉内核拷贝和中间缓存；驱动不支持时自动退回读写模式
+// 运行时可用环境变量 ECHO_AUDIO_MMAP=0/1 覆盖，ECHO_AUDIO_BENCH=<秒> 启动时对比两种模式的 CPU 开销
+#define AUDIO_MMAP 1
+
+// 录音环形缓冲区保留的历史时长 (ms)
+// 缓冲区总长 = 这段历史 + 消费者允许的最大积压，唤醒后可以回看这么久的音频
+#define AUDIO_PREROLL_MS 1000
+
+// 双麦合成方式 (MicArray::Mode): 0 = 只用左声道, 1 = 左右平均, 2 = 延迟求和波束
+#define AUDIO_MIC_MODE 1
+
+// 延迟求和的固定指向：右麦相对左麦的到达延迟，Q8 样本 (256 = 1 个样本 = 62.5us)
+// 0 表示正前方 (两麦连线的垂直方向)；正值指向左麦一侧，负值指向右麦一侧
+#define AUDIO_BEAM_DELAY_Q8 0
+
+// 录音文件写入 (WavWriter)：录音线程和写文件线程之间的缓冲时长 (ms)
+// Flash 卡住超过这么久才会开始丢录音数据
+#define WAV_WRITER_BUFFER_MS 4000
+
+// fsync 策略 (WavWriter::SyncPolicy): 0 = 从不, 1 = 关闭文件时, 2 = 每写 WAV_FSYNC_BYTES 字节一次
+#define WAV_FSYNC_POLICY 2
+#define WAV_FSYNC_BYTES (128 * 1024)
+
+// 内存录音 (UtteranceBuffer) 一句话最多保存的时长 (ms)，需大于 ENDPOINT_MAX_RECORD_MS + WAKE_PREROLL_MS
+#define UTTERANCE_MAX_MS 12000
+
+// 自适应 VAD (VadEngine)，录音线程上对每个 10ms 帧运行，定点实现
+// 子带信噪比 (dB) 从 VAD_SNR_LOW_DB 到 VAD_SNR_HIGH_DB 线性映射成 0..255 的语音概率
+#define VAD_SNR_LOW_DB 3
+#define VAD_SNR_HIGH_DB 12
+// 平滑后的概率超过 ON 进入 "说话"，低于 OFF 才退出 (0..255)
+#define VAD_SPEECH_ON 150
+#define VAD_SPEECH_OFF 80
+// 噪声底每帧最多上抬多少 (log2 能量的 Q8；2 ≈ 每秒 2.3dB)，持续的背景噪声几秒后被当成新的底
+#define VAD_FLOOR_RISE_Q8 2
+// 低于这个 RMS 的帧一律不算说话
+#define VAD_MIN_RMS 30
+
+// ==========================================
+// 对话 (ChatApp)
+// ==========================================
+
+// 唤醒后从 "唤醒词结束时刻 - WAKE_PREROLL_MS" 开始录音，
+// 保住用户紧跟着唤醒词说出的第一个音节
+#define WAKE_PREROLL_MS 200
+
+// 提示音 ("嗯?") 播放期间的录音不进 VAD 也不进上传 (喇叭的声音会被麦克风录进去)；
+// 播放队列空了之后再等硬件缓冲区播完，外加这么久的余量 (房间回声、VAD 概率回落)
+#define LISTEN_PROMPT_GUARD_MS 150
+
+// 说完判定 (Endpointer)：按 VAD 帧 (10ms) 判定，结尾要等的静音随这一句话自适应
+// 短指令 (< SHORT) 等 MIN_HANGOVER，长句 (> LONG) 等 MAX_HANGOVER，中间线性；句中停顿过的话至少比最长停顿再长 1/4
+#define ENDPOINT_MIN_HANGOVER_MS 400
+#define ENDPOINT_MAX_HANGOVER_MS 1500
+#define ENDPOINT_SHORT_MS 1000
+#define ENDPOINT_LONG_MS 5000
+// 多长的静音之后又开口才算一次句中停顿
+#define ENDPOINT_PAUSE_MIN_MS 150
+// 连续多长的语音才算开口 (滤掉咔哒声)
+#define ENDPOINT_MIN_SPEECH_MS 64
+// 一直没开口多久就放弃；一句话最多录多久 (需小于 UTTERANCE_MAX_MS - WAKE_PREROLL_MS)
+#define ENDPOINT_NO_SPEECH_MS 5000
+#define ENDPOINT_MAX_RECORD_MS 10000
+
+// 边说边传：ListeningState 每读到一帧就通过分块 HTTP 发给服务器 (/chat_stream)，
+// 检测到说完时服务器已经拿到了全部音频；流式请求失败时 ThinkingState 退回整段上传
+// 置 0 则恢复为说完之后再整段上传 (/chat)
+#define CHAT_STREAM_UPLOAD 1
+#define CHAT_STREAM_ENDPOINT "/chat_stream"
+
+// 边下边播：回复音频不再先存成 reply.wav，下载的同时解析 WAV 送进播放队列
+// 播放前先攒 REPLY_PREFILL_MS 的数据吸收网络抖动；置 0 则恢复为下载完再播放
+#define REPLY_STREAM_PLAYBACK 1
+#define REPLY_PREFILL_MS 200
+
+// 回复音频要求服务器用 IMA-ADPCM (WAV 格式 0x11，约为 16bit PCM 的 1/4)，设备边收边解码，
+// 下载时间和 reply.wav 占用的 Flash 都降到约 1/4；置 0 则要 16bit PCM
+#define REPLY_AUDIO_ADPCM 1
+
+// 单次往返：上传请求的回复里直接带上音频 (分帧格式，见 ChatReplyParser.h)，
+// 不再拿到 JSON 后再 GET audio_url，每轮省一次往返；置 0 则恢复为两次请求
+// 音频是边收边播的，所以要求 REPLY_STREAM_PLAYBACK = 1
+#define CHAT_INLINE_REPLY 1
+
+#if CHAT_INLINE_REPLY && !REPLY_STREAM_PLAYBACK
+#error "CHAT_INLINE_REPLY requires REPLY_STREAM_PLAYBACK"
+#endif
+
+// 按句流水线：服务器边收 LLM 的输出边断句，每句合成好就作为单独的一段发过来，
+// 设备把各段接在播放队列后面连续播放 (第 N 句在播时第 N+1 句还在路上)，首句不用等整段回复
+// 只在单次往返模式下有效
+#define REPLY_SENTENCE_PIPELINE 1
+
+#if REPLY_SENTENCE_PIPELINE && !CHAT_INLINE_REPLY
+#error "REPLY_SENTENCE_PIPELINE requires CHAT_INLINE_REPLY"
+#endif
+
+// 上传音频的编码 (AudioEncoder::Codec)，整段上传和边说边传都适用:
+// 0 = 16bit 裸 PCM (32KB/s), 1 = IMA-ADPCM (约 1/4 大小，有损), 2 = LPC + Rice 无损 (约 1/2 ~ 1/3 大小)
+// 服务器不支持时回 415，设备自动改回 PCM
+#define CHAT_UPLOAD_CODEC 1
+
+// ==========================================
+// 网络 (NetworkClient)
+// ==========================================
+
+// 空闲连接最多保留多久 (s)，期间的请求直接复用 TCP 连接，不再握手 (服务器需支持 HTTP/1.1 keep-alive)
+#define NET_CONN_MAX_AGE_S 300
+// 连接池里最多缓存的 easy 句柄数
+#define NET_HANDLE_POOL_SIZE 4
+// 唤醒时先发一个 HEAD 请求把连接建好，握手和用户说话同时进行
+#define NET_PREWARM_ENDPOINT "/ping"
+// 每个请求结束时打印 DNS/TCP 连接/首字节/总耗时，以及连接是否复用
+#define NET_LOG_TIMING 1
+
+// ==========================================
+// 唤醒词 (WakeWordEngine)
+// ==========================================
+
+// Snowboy 模型路径：整个进程只加载一份，桌面待机 (main) 和 IdleState 共用
+#define SNOWBOY_RES   "third_party/snowboy/resources/common.res"
+#define SNOWBOY_MODEL "third_party/snowboy/resources/snowboy.umdl"
+#define SNOWBOY_SENSITIVITY "0.5"
+// 每次交给 Snowboy 的音频长度 (ms)，和 ALSA 周期无关；Snowboy 内部按 10ms 帧移提特征，取 10ms 的整数倍
+#define WAKE_HOP_MS 30
+// 检测线程 -> 主循环的唤醒事件队列长度 (主循环每 5ms 取一次，几个就够)
+#define WAKE_EVENT_QUEUE 8
+
+// 唤醒检测的前级能量门 (WakeGate)：安静时跳过 Snowboy，降低待机 CPU；置 0 则每一帧都跑 Snowboy
+#define WAKE_GATE 1
+// 低于这个 RMS 的帧一律不开门
+#define WAKE_GATE_MIN_RMS 60
+// 能量超过噪声底多少倍开门 (4 倍 = 6dB)
+#define WAKE_GATE_ENERGY_RATIO 4
+// 能量超过 2 倍噪声底、且每 1000 对样本过零次数不少于这个值时也开门 (清擦音)
+#define WAKE_GATE_ZCR_MIN 250
+// 开门后至少保持多久 (ms)，覆盖整个唤醒词
+#define WAKE_GATE_HANG_MS 1500
+// 开门时把录音游标往回拨多久 (ms) 重新交给 Snowboy，唤醒词开头不会丢
+#define WAKE_GATE_LOOKBACK_MS 400
+// 检测线程每处理这么多秒的音频打印一次 CPU 占用 (0 = 只在唤醒时打印)
+#define WAKE_STATS_PERIOD_S 300
+
+#endif // CONFIG_H
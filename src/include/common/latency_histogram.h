@@ -0,0 +1,89 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+#include <stdio.h>
+
+// 延迟直方图：固定的毫秒分桶，一个线程 Add()，其他线程可以随时 Log()
+// 计数用 relaxed 原子量，打印时各桶之间不保证是同一瞬间的快照，对统计用途足够
+class LatencyHistogram {
+public:
+    // 各桶的上界 (ms)，最后一桶收所有更大的值
+    static const int kBuckets = 10;
+
+    LatencyHistogram() { Clear(); }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    void operator=(const LatencyHistogram&) = delete;
+
+    void Add(uint64_t us) {
+        int i = 0;
+        while (i < kBuckets - 1 && us > (uint64_t)Bound(i) * 1000) i++;
+        counts_[i].fetch_add(1, std::memory_order_relaxed);
+        total_.fetch_add(1, std::memory_order_relaxed);
+        sum_us_.fetch_add(us, std::memory_order_relaxed);
+        uint64_t max = max_us_.load(std::memory_order_relaxed);
+        if (us > max) max_us_.store(us, std::memory_order_relaxed);
+    }
+
+    void Clear() {
+        for (int i = 0; i < kBuckets; i++) counts_[i].store(0, std::memory_order_relaxed);
+        total_.store(0, std::memory_order_relaxed);
+        sum_us_.store(0, std::memory_order_relaxed);
+        max_us_.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t Count() const { return total_.load(std::memory_order_relaxed); }
+    uint64_t MaxUs() const { return max_us_.load(std::memory_order_relaxed); }
+
+    // 百分位 (ms)：返回落点所在桶的上界，最后一桶返回最大值
+    uint64_t PercentileMs(unsigned int pct) const {
+        uint64_t total = Count();
+        if (total == 0) return 0;
+        uint64_t target = (total * pct + 99) / 100;
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets - 1; i++) {
+            seen += counts_[i].load(std::memory_order_relaxed);
+            if (seen >= target) return Bound(i);
+        }
+        return MaxUs() / 1000;
+    }
+
+    // 一行打印：次数、平均、p50/p90/p99、最大值，以及非空的桶
+    void Log(const char* name) const {
+        uint64_t total = Count();
+        if (total == 0) {
+            printf("[Latency] %s: no samples\n", name);
+            return;
+        }
+        char buckets[256];
+        int len = 0;
+        for (int i = 0; i < kBuckets && len < (int)sizeof(buckets); i++) {
+            uint64_t n = counts_[i].load(std::memory_order_relaxed);
+            if (n == 0) continue;
+            if (i < kBuckets - 1) {
+                len += snprintf(buckets + len, sizeof(buckets) - len, " <=%d:%llu", Bound(i), (unsigned long long)n);
+            } else {
+                len += snprintf(buckets + len, sizeof(buckets) - len, " >%d:%llu", Bound(i - 1), (unsigned long long)n);
+            }
+        }
+        printf("[Latency] %s: n=%llu avg=%.1fms p50<=%llums p90<=%llums p99<=%llums max=%.1fms |%s\n", name,
+               (unsigned long long)total, sum_us_.load(std::memory_order_relaxed) / 1000.0 / total,
+               (unsigned long long)PercentileMs(50), (unsigned long long)PercentileMs(90),
+               (unsigned long long)PercentileMs(99), MaxUs() / 1000.0, buckets);
+    }
+
+private:
+    static int Bound(int i) {
+        static const int kBoundsMs[kBuckets - 1] = { 1, 2, 5, 10, 20, 50, 100, 200, 500 };
+        return kBoundsMs[i];
+    }
+
+    std::atomic<uint64_t> counts_[kBuckets];
+    std::atomic<uint64_t> total_;
+    std::atomic<uint64_t> sum_us_;
+    std::atomic<uint64_t> max_us_;
+};
+
+#endif // LATENCY_HISTOGRAM_H
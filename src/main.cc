@@ -15,10 +15,7 @@ extern "C" {
 #include "services/audio/AudioProcess.h"      // 必须显式引用，因为 main 要获取录音数据
 #include "services/wakeword/WakeWordEngine.h" // 新增：唤醒引擎
 #include "app/AI_chat/chat_app.h"
-
-// Snowboy 模型路径
-#define SNOWBOY_RES   "third_party/snowboy/resources/common.res"
-#define SNOWBOY_MODEL "third_party/snowboy/resources/snowboy.umdl"
+#include "common/config.h"                    // Snowboy 模型路径
 
 int main(void)
 {
@@ -35,17 +32,21 @@ int main(void)
 
     /* 4. 初始化 系统级服务 (唤醒引擎) */
     printf(">>> [Main] Initializing WakeWord Engine...\n");
-    WakeWordEngine wake_engine;
-    wake_engine.Init(SNOWBOY_RES, SNOWBOY_MODEL);    
+    // 全局唯一的检测器，IdleState 也用这一份模型
+    WakeWordEngine& wake_engine = WakeWordEngine::GetInstance();
+    wake_engine.Init(SNOWBOY_RES, SNOWBOY_MODEL);
 
     /* 5. 初始化 AI App (它内部会自动创建 AudioProcess) */
     printf(">>> [Main] Initializing ChatApp Core...\n");
     ChatApp robot; 
     robot.Init(); 
 
-    /* 6. 主循环 */
+    /* 6. 唤醒检测放到自己的线程里 (它拥有自己的录音游标，不会和 ChatApp 内部的消费者抢数据)，
+     *    主循环只负责 UI 和取唤醒事件 */
+    wake_engine.Start();
+
+    /* 7. 主循环 */
     printf(">>> [Main] Entering System Loop...\n");
-    std::vector<int16_t> audio_frame; // 用于暂存从音频服务拿到的数据
 
     while (1) {
         /* --- UI 任务 (永远运行) --- */
@@ -58,23 +59,29 @@ int main(void)
         // 如果你还没写 IsRunning，可以用一个简单的 bool 变量在 main 里控制，或者去 ChatApp 加一个
         if (robot.IsRunning()) {
             robot.RunOnce(); 
+            // 会话结束 (RunOnce 里 Stop 了)：恢复唤醒检测，检测线程会跳过对话期间的音频并 Reset 检测器
+            if (!robot.IsRunning()) wake_engine.SetEnabled(true);
         } 
         else {
-            if (AudioProcess::GetInstance().GetFrame(audio_frame)) {
-                // 喂给唤醒引擎
-                int ret = wake_engine.Detect(audio_frame);
-                
-                if (ret > 0) {
-                    printf(">>> Wake Word Detected! Launching Robot... ⚡️ <<<\n");
-                    // 启动机器人
-                    robot.Start(); 
-                    // 唤醒后清空缓冲区，防止"Snowboy"这个词的声音被录进去
-                    AudioProcess::GetInstance().ClearBuff();
-                }
+            WakeEvent wake;
+            if (wake_engine.PollEvent(wake)) {
+                printf(">>> Wake Word Detected! Launching Robot... ⚡️ <<<\n");
+                wake_engine.LogStats();
+                printf("[Main] Wake event latency: %.1f ms\n", wake.latency_us / 1000.0);
+                // 对话期间不做唤醒检测
+                wake_engine.SetEnabled(false);
+                // 唤醒词结束的时刻交给 ChatApp，
+                // 录音会从它之前 WAKE_PREROLL_MS 开始，紧跟唤醒词说的话不会丢
+                robot.Start(wake.time_us); 
             }
         }
 
-        usleep(5000); // 5ms 休眠
+        if (robot.IsRunning()) {
+            usleep(5000); // 5ms 休眠
+        } else {
+            // 最多休眠 5ms；检测线程发出唤醒事件时立刻醒来
+            wake_engine.WaitEvent(5);
+        }
     }
 
     return 0;
@@ -0,0 +1,273 @@
+#include "AudioEncoder.h"
+#include "ImaAdpcm.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <time.h>
+
+// 无损模式：LPC 系数最多量化到 Q12
+#define LPC_MAX_SHIFT 12
+// 无损模式：每段残差共用一个 Rice 参数 k
+#define RICE_PARTITION 256
+// 商 (u >> k) 达到这么大时改为转义：ESCAPE 个 1 之后直接写 17bit 原值
+#define RICE_ESCAPE 24
+#define RICE_RAW_BITS 17
+
+static long ThreadCpuUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+static void PutLE16(std::vector<uint8_t>& out, size_t pos, uint16_t v) {
+    out[pos] = (uint8_t)(v & 0xFF);
+    out[pos + 1] = (uint8_t)(v >> 8);
+}
+
+// MSB 在前的比特写入器，最后不满一个字节的部分补 0
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+    // nbits <= 32
+    void Put(uint32_t value, int nbits) {
+        acc_ = (acc_ << nbits) | value;
+        bits_ += nbits;
+        while (bits_ >= 8) {
+            bits_ -= 8;
+            out_.push_back((uint8_t)(acc_ >> bits_));
+        }
+    }
+
+    void Flush() {
+        if (bits_ > 0) Put(0, 8 - bits_);
+    }
+
+private:
+    std::vector<uint8_t>& out_;
+    uint64_t acc_ = 0;
+    int bits_ = 0;
+};
+
+const char* AudioEncoder::CodecName(Codec codec) {
+    switch (codec) {
+        case kAdpcm: return "adpcm";
+        case kLossless: return "lpc";
+        case kPcm: break;
+    }
+    return "pcm";
+}
+
+AudioEncoder::AudioEncoder(Codec codec) {
+    pending_.reserve(CODEC_BLOCK_SAMPLES);
+    residual_.resize(CODEC_BLOCK_SAMPLES);
+    Reset(codec);
+}
+
+void AudioEncoder::Reset(Codec codec) {
+    codec_ = codec;
+    pending_.clear();
+    adpcm_ = ImaAdpcm::State();
+    memset(history_, 0, sizeof(history_));
+    in_bytes_ = 0;
+    out_bytes_ = 0;
+    cpu_us_ = 0;
+}
+
+void AudioEncoder::Encode(const int16_t* pcm, size_t n, std::vector<uint8_t>& out) {
+    long start = ThreadCpuUs();
+    size_t old_size = out.size();
+    in_bytes_ += n * sizeof(int16_t);
+
+    if (codec_ == kPcm) {
+        out.insert(out.end(), (const uint8_t*)pcm, (const uint8_t*)(pcm + n));
+    } else {
+        // 先把上次剩下的半块补满
+        if (!pending_.empty()) {
+            size_t take = CODEC_BLOCK_SAMPLES - pending_.size();
+            if (take > n) take = n;
+            pending_.insert(pending_.end(), pcm, pcm + take);
+            pcm += take;
+            n -= take;
+            if (pending_.size() == CODEC_BLOCK_SAMPLES) {
+                EncodeBlock(pending_.data(), pending_.size(), out);
+                pending_.clear();
+            }
+        }
+        // 整块直接从调用方的缓冲区编码
+        while (n >= CODEC_BLOCK_SAMPLES) {
+            EncodeBlock(pcm, CODEC_BLOCK_SAMPLES, out);
+            pcm += CODEC_BLOCK_SAMPLES;
+            n -= CODEC_BLOCK_SAMPLES;
+        }
+        pending_.insert(pending_.end(), pcm, pcm + n);
+    }
+
+    out_bytes_ += out.size() - old_size;
+    cpu_us_ += ThreadCpuUs() - start;
+}
+
+void AudioEncoder::Flush(std::vector<uint8_t>& out) {
+    if (pending_.empty()) return;
+    long start = ThreadCpuUs();
+    size_t old_size = out.size();
+
+    EncodeBlock(pending_.data(), pending_.size(), out);
+    pending_.clear();
+
+    out_bytes_ += out.size() - old_size;
+    cpu_us_ += ThreadCpuUs() - start;
+}
+
+// 包头 = 样本数 + 负载字节数，负载长度编码完才知道，先占位再回填
+void AudioEncoder::EncodeBlock(const int16_t* pcm, size_t n, std::vector<uint8_t>& out) {
+    size_t header = out.size();
+    out.resize(header + 4);
+
+    if (codec_ == kAdpcm) {
+        EncodeAdpcm(pcm, n, out);
+    } else {
+        EncodeLossless(pcm, n, out);
+    }
+
+    PutLE16(out, header, (uint16_t)n);
+    PutLE16(out, header + 2, (uint16_t)(out.size() - header - 4));
+}
+
+// 标准 IMA-ADPCM；块头记下编码这一块之前的预测状态，解码端可以从任意一块开始
+void AudioEncoder::EncodeAdpcm(const int16_t* pcm, size_t n, std::vector<uint8_t>& out) {
+    size_t pos = out.size();
+    out.resize(pos + 4 + (n + 1) / 2);
+    PutLE16(out, pos, (uint16_t)(int16_t)adpcm_.predictor);
+    uint8_t* p = out.data() + pos;
+    p[2] = (uint8_t)adpcm_.index;
+    p[3] = 0;
+    p += 4;
+
+    for (size_t i = 0; i < n; i++) {
+        int code = ImaAdpcm::Encode(adpcm_, pcm[i]);
+        if (i & 1) {
+            p[i / 2] |= (uint8_t)(code << 4);
+        } else {
+            p[i / 2] = (uint8_t)code;
+        }
+    }
+}
+
+// 自相关 + Levinson-Durbin 求 order 阶预测系数；信号太弱/病态时返回 0 (不做预测)
+static int LevinsonDurbin(const int16_t* pcm, size_t n, int order, double* coefs) {
+    double r[CODEC_LPC_ORDER + 1];
+    for (int lag = 0; lag <= order; lag++) {
+        double sum = 0;
+        for (size_t i = lag; i < n; i++) sum += (double)pcm[i] * pcm[i - lag];
+        r[lag] = sum;
+    }
+    if (r[0] <= 0) return 0;
+
+    double a[CODEC_LPC_ORDER + 1] = { 0 };
+    double tmp[CODEC_LPC_ORDER + 1];
+    double err = r[0];
+    for (int i = 1; i <= order; i++) {
+        double acc = r[i];
+        for (int j = 1; j < i; j++) acc -= a[j] * r[i - j];
+        double k = acc / err;
+        memcpy(tmp, a, sizeof(a));
+        a[i] = k;
+        for (int j = 1; j < i; j++) a[j] = tmp[j] - k * tmp[i - j];
+        err *= 1.0 - k * k;
+        if (err <= 0) return 0;
+    }
+    for (int i = 0; i < order; i++) coefs[i] = a[i + 1];
+    return order;
+}
+
+static inline uint32_t ZigZag(int32_t v) {
+    return v >= 0 ? (uint32_t)v << 1 : ((uint32_t)(-v) << 1) - 1;
+}
+
+// 预测从块内样本取历史，不够时取上一块末尾的样本
+static inline int32_t LpcSample(const int16_t* pcm, const int32_t* history, long t) {
+    return t >= 0 ? pcm[t] : history[-t - 1];
+}
+
+// 残差 (zigzag) 写进 residual，返回残差之和 (用来和不预测时比较)
+static uint64_t LpcResidual(const int16_t* pcm, size_t n, const int32_t* history,
+                            const int32_t* q, int order, int shift, uint32_t* residual) {
+    uint64_t total = 0;
+    for (size_t t = 0; t < n; t++) {
+        int64_t acc = 0;
+        for (int i = 0; i < order; i++) acc += (int64_t)q[i] * LpcSample(pcm, history, (long)t - 1 - i);
+        // 解码端同样按算术右移 (向下取整) 再截断到 16bit，结果才能逐样本一致
+        int64_t pred = acc >> shift;
+        if (pred > 32767) pred = 32767;
+        if (pred < -32768) pred = -32768;
+        residual[t] = ZigZag((int32_t)(pcm[t] - pred));
+        total += residual[t];
+    }
+    return total;
+}
+
+void AudioEncoder::EncodeLossless(const int16_t* pcm, size_t n, std::vector<uint8_t>& out) {
+    double coefs[CODEC_LPC_ORDER];
+    int32_t q[CODEC_LPC_ORDER];
+    int order = n > 2 * CODEC_LPC_ORDER ? LevinsonDurbin(pcm, n, CODEC_LPC_ORDER, coefs) : 0;
+
+    // 系数量化成整数：量化位数尽量高，但系数要放得进 int16
+    int shift = LPC_MAX_SHIFT;
+    if (order > 0) {
+        double max_abs = 0;
+        for (int i = 0; i < order; i++) max_abs = std::max(max_abs, std::fabs(coefs[i]));
+        while (shift > 0 && max_abs * (1 << shift) > 32767) shift--;
+        for (int i = 0; i < order; i++) q[i] = (int32_t)lround(coefs[i] * (1 << shift));
+    }
+
+    uint32_t* residual = residual_.data();
+    uint64_t lpc_cost = order > 0 ? LpcResidual(pcm, n, history_, q, order, shift, residual) : 0;
+    // 预测反而更差 (噪声、突变) 时退回不预测
+    uint64_t raw_cost = 0;
+    for (size_t t = 0; t < n; t++) raw_cost += ZigZag(pcm[t]);
+    if (order == 0 || lpc_cost >= raw_cost) {
+        order = 0;
+        shift = 0;
+        for (size_t t = 0; t < n; t++) residual[t] = ZigZag(pcm[t]);
+    }
+
+    out.push_back((uint8_t)order);
+    out.push_back((uint8_t)shift);
+    for (int i = 0; i < order; i++) {
+        out.push_back((uint8_t)(q[i] & 0xFF));
+        out.push_back((uint8_t)((q[i] >> 8) & 0xFF));
+    }
+
+    BitWriter bits(out);
+    for (size_t start = 0; start < n; start += RICE_PARTITION) {
+        size_t end = std::min(n, start + (size_t)RICE_PARTITION);
+        uint64_t count = end - start;
+        uint64_t sum = 0;
+        for (size_t t = start; t < end; t++) sum += residual[t];
+
+        // k 取 log2(平均值)
+        int k = 0;
+        while (k < 16 && (count << (k + 1)) <= sum) k++;
+        bits.Put((uint32_t)k, 5);
+
+        for (size_t t = start; t < end; t++) {
+            uint32_t u = residual[t];
+            uint32_t high = u >> k;
+            if (high < RICE_ESCAPE) {
+                // high 个 1 + 一个 0，再跟 k 个低位
+                bits.Put(((1u << high) - 1) << 1, (int)high + 1);
+                if (k > 0) bits.Put(u & ((1u << k) - 1), k);
+            } else {
+                bits.Put((1u << RICE_ESCAPE) - 1, RICE_ESCAPE);
+                bits.Put(u, RICE_RAW_BITS);
+            }
+        }
+    }
+    bits.Flush();
+
+    // 下一块的预测历史：本块最后几个样本接在旧历史前面
+    int32_t next[CODEC_LPC_ORDER];
+    for (int i = 0; i < CODEC_LPC_ORDER; i++) next[i] = LpcSample(pcm, history_, (long)n - 1 - i);
+    memcpy(history_, next, sizeof(history_));
+}
@@ -0,0 +1,83 @@
+/**
+ * @file AudioEncoder.h
+ * @brief 上传音频的流式编码器 (IMA-ADPCM / LPC + Rice 无损)
+ *
+ * 16kHz 16bit 裸 PCM 是 32KB/s，一句 10 秒的话要传 320KB，弱 Wi-Fi 下很慢。这里先压缩再上传:
+ * 1. kAdpcm: IMA-ADPCM，每个样本 4bit (约 4:1，有损)，每样本只有几次加减和比较，A7 上几乎不占 CPU。
+ * 2. kLossless: 每块做一次 CODEC_LPC_ORDER 阶 LPC (Levinson-Durbin，系数量化成整数)，残差用 Rice 码，
+ *    解码结果和原始 PCM 逐样本一致，适合对识别准确率敏感的部署。
+ * 3. kPcm: 不压缩，原样输出 (服务器不支持编码时的退路)。
+ *
+ * 码流由若干 "包" 组成，每包是一块 (最多 CODEC_BLOCK_SAMPLES 个样本):
+ *   { 样本数(2, 小端) | 负载字节数(2, 小端) | 负载 }
+ * ADPCM 负载 = 块开始时的预测值(2) + 步长索引(1) + 保留(1) + 每样本 4bit (低半字节在前)，每块可以单独解码；
+ * 无损负载 = 阶数(1) + 量化位数(1) + 系数(2 x 阶数) + 按 256 样本分段的 Rice 码 (每段 5bit 的 k)，
+ *   预测用到的历史样本跨块延续 (码流开头视为 0)，所以必须从头顺序解码。
+ * 服务器端的解码器见 server/upload_codec.py，两边的定义必须一致。
+ *
+ * Encode() 可以按任意大小喂数据 (边说边传时一帧一帧地喂)，凑满一块才输出；说完时 Flush() 输出剩下的半块。
+ */
+
+#ifndef AUDIO_ENCODER_H
+#define AUDIO_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ImaAdpcm.h"
+
+// 每块的样本数 (64ms @ 16kHz)：边说边传时最多压着这么多样本没发出去
+#define CODEC_BLOCK_SAMPLES 1024
+// 无损模式的 LPC 阶数上限
+#define CODEC_LPC_ORDER 8
+
+class AudioEncoder {
+public:
+    enum Codec {
+        kPcm = 0,
+        kAdpcm = 1,
+        kLossless = 2,
+    };
+
+    // 协商时用的名字 (上传请求里的 codec 字段)
+    static const char* CodecName(Codec codec);
+
+    explicit AudioEncoder(Codec codec = kPcm);
+
+    // 开始一段新的码流 (清空预测状态和统计)
+    void Reset(Codec codec);
+    Codec GetCodec() const { return codec_; }
+
+    // 编码 n 个单声道样本，完整的块追加到 out
+    void Encode(const int16_t* pcm, size_t n, std::vector<uint8_t>& out);
+    // 码流结束：输出还没凑满的最后一块
+    void Flush(std::vector<uint8_t>& out);
+
+    // --- 统计 (本段码流) ---
+    size_t InputBytes() const { return in_bytes_; }
+    size_t OutputBytes() const { return out_bytes_; }
+    // 编码花掉的 CPU 时间 (调用线程的 CPU 时间，微秒)
+    long CpuUs() const { return cpu_us_; }
+
+private:
+    void EncodeBlock(const int16_t* pcm, size_t n, std::vector<uint8_t>& out);
+    void EncodeAdpcm(const int16_t* pcm, size_t n, std::vector<uint8_t>& out);
+    void EncodeLossless(const int16_t* pcm, size_t n, std::vector<uint8_t>& out);
+
+    Codec codec_;
+    std::vector<int16_t> pending_;  // 还没凑满一块的样本
+
+    // ADPCM 状态
+    ImaAdpcm::State adpcm_;
+
+    // 无损：上一块末尾的样本 (history_[0] 是最近的一个)
+    int32_t history_[CODEC_LPC_ORDER];
+    std::vector<uint32_t> residual_; // 每块的残差 (zigzag 之后)，预分配避免每块分配
+
+    size_t in_bytes_;
+    size_t out_bytes_;
+    long cpu_us_;
+};
+
+#endif // AUDIO_ENCODER_H
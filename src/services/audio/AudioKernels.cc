@@ -0,0 +1,296 @@
+#include "AudioKernels.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AUDIO_KERNELS_HAVE_NEON 1
+#else
+#define AUDIO_KERNELS_HAVE_NEON 0
+#endif
+
+namespace AudioKernels {
+
+// Q12 增益限制在 int16 范围内 (最大约 8 倍)，NEON 的乘法指令只接受 16 位标量
+static inline int16_t ClampGain(int32_t gain_q12) {
+    if (gain_q12 > 32767) return 32767;
+    if (gain_q12 < -32768) return -32768;
+    return (int16_t)gain_q12;
+}
+
+static inline int16_t Saturate16(int32_t v) {
+    if (v > 32767) return 32767;
+    if (v < -32768) return -32768;
+    return (int16_t)v;
+}
+
+// ==========================================
+// 标量参考实现
+// ==========================================
+
+namespace Scalar {
+
+void Deinterleave(const int16_t* stereo, int16_t* mono, size_t frames, int channel) {
+    for (size_t i = 0; i < frames; ++i) {
+        mono[i] = stereo[2 * i + channel];
+    }
+}
+
+void Interleave(const int16_t* left, const int16_t* right, int16_t* stereo, size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        stereo[2 * i]     = left[i];
+        stereo[2 * i + 1] = right[i];
+    }
+}
+
+void Duplicate(const int16_t* mono, int16_t* stereo, size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        stereo[2 * i]     = mono[i];
+        stereo[2 * i + 1] = mono[i];
+    }
+}
+
+void MixDown(const int16_t* stereo, int16_t* mono, size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        mono[i] = (int16_t)(((int32_t)stereo[2 * i] + stereo[2 * i + 1]) >> 1);
+    }
+}
+
+void ApplyGain(int16_t* data, size_t n, int32_t gain_q12) {
+    int32_t g = ClampGain(gain_q12);
+    for (size_t i = 0; i < n; ++i) {
+        data[i] = Saturate16((data[i] * g + (1 << 11)) >> 12);
+    }
+}
+
+uint64_t Energy(const int16_t* data, size_t n) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += (uint64_t)((int32_t)data[i] * data[i]);
+    }
+    return sum;
+}
+
+uint32_t ZeroCrossings(const int16_t* data, size_t n) {
+    uint32_t count = 0;
+    for (size_t i = 0; i + 1 < n; ++i) {
+        count += (uint32_t)(((uint16_t)(data[i] ^ data[i + 1])) >> 15);
+    }
+    return count;
+}
+
+} // namespace Scalar
+
+// ==========================================
+// NEON 实现 (每次 8 个样本，尾部交给标量)
+// ==========================================
+
+#if AUDIO_KERNELS_HAVE_NEON
+namespace Neon {
+
+static void Deinterleave(const int16_t* stereo, int16_t* mono, size_t frames, int channel) {
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        int16x8x2_t lr = vld2q_s16(stereo + 2 * i);
+        vst1q_s16(mono + i, channel ? lr.val[1] : lr.val[0]);
+    }
+    Scalar::Deinterleave(stereo + 2 * i, mono + i, frames - i, channel);
+}
+
+static void Interleave(const int16_t* left, const int16_t* right, int16_t* stereo, size_t frames) {
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        int16x8x2_t lr;
+        lr.val[0] = vld1q_s16(left + i);
+        lr.val[1] = vld1q_s16(right + i);
+        vst2q_s16(stereo + 2 * i, lr);
+    }
+    Scalar::Interleave(left + i, right + i, stereo + 2 * i, frames - i);
+}
+
+static void Duplicate(const int16_t* mono, int16_t* stereo, size_t frames) {
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        int16x8x2_t lr;
+        lr.val[0] = vld1q_s16(mono + i);
+        lr.val[1] = lr.val[0];
+        vst2q_s16(stereo + 2 * i, lr);
+    }
+    Scalar::Duplicate(mono + i, stereo + 2 * i, frames - i);
+}
+
+static void MixDown(const int16_t* stereo, int16_t* mono, size_t frames) {
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        int16x8x2_t lr = vld2q_s16(stereo + 2 * i);
+        // vhadd: (a + b) >> 1，内部不溢出，与标量版本的算术右移一致
+        vst1q_s16(mono + i, vhaddq_s16(lr.val[0], lr.val[1]));
+    }
+    Scalar::MixDown(stereo + 2 * i, mono + i, frames - i);
+}
+
+static void ApplyGain(int16_t* data, size_t n, int32_t gain_q12) {
+    int16_t g = ClampGain(gain_q12);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t x = vld1q_s16(data + i);
+        int32x4_t lo = vmull_n_s16(vget_low_s16(x), g);
+        int32x4_t hi = vmull_n_s16(vget_high_s16(x), g);
+        // vqrshrn: 四舍五入右移 12 位并饱和到 int16
+        vst1q_s16(data + i, vcombine_s16(vqrshrn_n_s32(lo, 12), vqrshrn_n_s32(hi, 12)));
+    }
+    Scalar::ApplyGain(data + i, n - i, gain_q12);
+}
+
+static uint64_t Energy(const int16_t* data, size_t n) {
+    // 单个平方最大 2^30，放得进 int32；两两相加时再扩到 int64 累加
+    int64x2_t acc = vdupq_n_s64(0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t x = vld1q_s16(data + i);
+        acc = vpadalq_s32(acc, vmull_s16(vget_low_s16(x), vget_low_s16(x)));
+        acc = vpadalq_s32(acc, vmull_s16(vget_high_s16(x), vget_high_s16(x)));
+    }
+    return (uint64_t)(vgetq_lane_s64(acc, 0) + vgetq_lane_s64(acc, 1)) + Scalar::Energy(data + i, n - i);
+}
+
+static uint32_t ZeroCrossings(const int16_t* data, size_t n) {
+    uint32x4_t acc = vdupq_n_u32(0);
+    size_t i = 0;
+    // 每次比较 8 对 (data[i..i+7] 和 data[i+1..i+8])
+    for (; i + 9 <= n; i += 8) {
+        int16x8_t a = vld1q_s16(data + i);
+        int16x8_t b = vld1q_s16(data + i + 1);
+        uint16x8_t diff = vshrq_n_u16(vreinterpretq_u16_s16(veorq_s16(a, b)), 15);
+        acc = vpadalq_u16(acc, diff);
+    }
+    uint32_t count = vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) + vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+    return count + Scalar::ZeroCrossings(data + i, n - i);
+}
+
+} // namespace Neon
+#endif
+
+// ==========================================
+// 分发
+// ==========================================
+
+static bool g_use_neon = AUDIO_KERNELS_HAVE_NEON;
+
+#if AUDIO_KERNELS_HAVE_NEON
+#define DISPATCH(fn, ...) do { if (g_use_neon) Neon::fn(__VA_ARGS__); else Scalar::fn(__VA_ARGS__); } while (0)
+#else
+#define DISPATCH(fn, ...) Scalar::fn(__VA_ARGS__)
+#endif
+
+void Deinterleave(const int16_t* stereo, int16_t* mono, size_t frames, int channel) {
+    DISPATCH(Deinterleave, stereo, mono, frames, channel);
+}
+
+void Interleave(const int16_t* left, const int16_t* right, int16_t* stereo, size_t frames) {
+    DISPATCH(Interleave, left, right, stereo, frames);
+}
+
+void Duplicate(const int16_t* mono, int16_t* stereo, size_t frames) {
+    DISPATCH(Duplicate, mono, stereo, frames);
+}
+
+void MixDown(const int16_t* stereo, int16_t* mono, size_t frames) {
+    DISPATCH(MixDown, stereo, mono, frames);
+}
+
+void ApplyGain(int16_t* data, size_t n, int32_t gain_q12) {
+    DISPATCH(ApplyGain, data, n, gain_q12);
+}
+
+uint64_t Energy(const int16_t* data, size_t n) {
+#if AUDIO_KERNELS_HAVE_NEON
+    if (g_use_neon) return Neon::Energy(data, n);
+#endif
+    return Scalar::Energy(data, n);
+}
+
+uint32_t ZeroCrossings(const int16_t* data, size_t n) {
+#if AUDIO_KERNELS_HAVE_NEON
+    if (g_use_neon) return Neon::ZeroCrossings(data, n);
+#endif
+    return Scalar::ZeroCrossings(data, n);
+}
+
+bool UsingNeon() {
+    return g_use_neon;
+}
+
+bool SelfTest() {
+#if AUDIO_KERNELS_HAVE_NEON
+    // 长度故意不是 8 的倍数，同时覆盖向量主体和标量尾部；数据包含满幅值以检查饱和
+    const size_t frames = 1027;
+    std::vector<int16_t> stereo(frames * 2), left(frames), right(frames);
+    uint32_t seed = 0x12345678;
+    for (size_t i = 0; i < stereo.size(); ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        stereo[i] = (i % 97 == 0) ? (i % 2 ? -32768 : 32767) : (int16_t)(seed >> 16);
+    }
+    Scalar::Deinterleave(stereo.data(), left.data(), frames, 0);
+    Scalar::Deinterleave(stereo.data(), right.data(), frames, 1);
+
+    std::vector<int16_t> ref(frames * 2), out(frames * 2);
+    bool ok = true;
+    const char* failed = "";
+
+    for (int ch = 0; ch < 2 && ok; ++ch) {
+        Scalar::Deinterleave(stereo.data(), ref.data(), frames, ch);
+        Neon::Deinterleave(stereo.data(), out.data(), frames, ch);
+        if (memcmp(ref.data(), out.data(), frames * sizeof(int16_t))) { ok = false; failed = "Deinterleave"; }
+    }
+
+    if (ok) {
+        Scalar::Interleave(left.data(), right.data(), ref.data(), frames);
+        Neon::Interleave(left.data(), right.data(), out.data(), frames);
+        if (memcmp(ref.data(), out.data(), frames * 2 * sizeof(int16_t))) { ok = false; failed = "Interleave"; }
+    }
+
+    if (ok) {
+        Scalar::Duplicate(left.data(), ref.data(), frames);
+        Neon::Duplicate(left.data(), out.data(), frames);
+        if (memcmp(ref.data(), out.data(), frames * 2 * sizeof(int16_t))) { ok = false; failed = "Duplicate"; }
+    }
+
+    if (ok) {
+        Scalar::MixDown(stereo.data(), ref.data(), frames);
+        Neon::MixDown(stereo.data(), out.data(), frames);
+        if (memcmp(ref.data(), out.data(), frames * sizeof(int16_t))) { ok = false; failed = "MixDown"; }
+    }
+
+    const int32_t gains[] = {0, 2048, 4096, 5793, 32767, -4096};
+    for (size_t k = 0; k < sizeof(gains) / sizeof(gains[0]) && ok; ++k) {
+        memcpy(ref.data(), stereo.data(), frames * 2 * sizeof(int16_t));
+        memcpy(out.data(), stereo.data(), frames * 2 * sizeof(int16_t));
+        Scalar::ApplyGain(ref.data(), frames * 2, gains[k]);
+        Neon::ApplyGain(out.data(), frames * 2, gains[k]);
+        if (memcmp(ref.data(), out.data(), frames * 2 * sizeof(int16_t))) { ok = false; failed = "ApplyGain"; }
+    }
+
+    if (ok && Scalar::Energy(stereo.data(), frames * 2) != Neon::Energy(stereo.data(), frames * 2)) {
+        ok = false;
+        failed = "Energy";
+    }
+    if (ok && Scalar::ZeroCrossings(stereo.data(), frames * 2) != Neon::ZeroCrossings(stereo.data(), frames * 2)) {
+        ok = false;
+        failed = "ZeroCrossings";
+    }
+
+    if (!ok) {
+        printf("[Audio] Kernel self-test FAILED (%s): NEON != scalar, falling back to scalar.\n", failed);
+        g_use_neon = false;
+        return false;
+    }
+    printf("[Audio] Kernel self-test passed (NEON).\n");
+#else
+    printf("[Audio] Kernel self-test skipped (no NEON, scalar kernels).\n");
+#endif
+    return true;
+}
+
+} // namespace AudioKernels
@@ -0,0 +1,61 @@
+/**
+ * @file AudioKernels.h
+ * @brief 声道转换/增益的基础运算核 (NEON + 标量参考实现)
+ *
+ * 录音/播放/唤醒检测线程每个周期都要做的逐样本循环集中在这里:
+ * 1. 在 ARM (定义了 __ARM_NEON) 上使用 NEON 一次处理 8 个样本，其余平台走标量实现。
+ * 2. Scalar 命名空间里的实现是 "标准答案"，NEON 版本必须逐样本一致。
+ * 3. SelfTest() 在设备启动时用合成数据比对两套实现，不一致就整体退回标量版本 (运行时兜底)；
+ *    构建时的回归由 tests/audio_kernels_test.cc (make test) 检查，奇数尾巴、饱和都在里面。
+ *
+ * 所有函数都只读写调用方给的内存，不分配、不加锁，可以直接在音频线程里调用。
+ */
+
+#ifndef AUDIO_KERNELS_H
+#define AUDIO_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace AudioKernels {
+
+// 交织双声道 -> 取其中一个声道 (channel: 0 = 左, 1 = 右)
+void Deinterleave(const int16_t* stereo, int16_t* mono, size_t frames, int channel);
+
+// 两个单声道 -> 交织双声道
+void Interleave(const int16_t* left, const int16_t* right, int16_t* stereo, size_t frames);
+
+// 单声道 -> 左右相同的双声道 (播放用)
+void Duplicate(const int16_t* mono, int16_t* stereo, size_t frames);
+
+// 交织双声道 -> (L + R) / 2 (向下取整)
+void MixDown(const int16_t* stereo, int16_t* mono, size_t frames);
+
+// 原地饱和增益，gain_q12 为 Q12 定点 (4096 = 1.0)，结果四舍五入
+void ApplyGain(int16_t* data, size_t n, int32_t gain_q12);
+
+// 平方和 (帧能量，除以 n 即均方值)，整数运算结果精确
+uint64_t Energy(const int16_t* data, size_t n);
+
+// 过零次数：相邻样本符号位不同的对数 (0 算正数)，共检查 n - 1 对
+uint32_t ZeroCrossings(const int16_t* data, size_t n);
+
+// 用合成数据比对 NEON 与标量实现；不一致时强制使用标量版本并返回 false
+bool SelfTest();
+
+// 当前是否在使用 NEON 实现
+bool UsingNeon();
+
+namespace Scalar {
+void Deinterleave(const int16_t* stereo, int16_t* mono, size_t frames, int channel);
+void Interleave(const int16_t* left, const int16_t* right, int16_t* stereo, size_t frames);
+void Duplicate(const int16_t* mono, int16_t* stereo, size_t frames);
+void MixDown(const int16_t* stereo, int16_t* mono, size_t frames);
+void ApplyGain(int16_t* data, size_t n, int32_t gain_q12);
+uint64_t Energy(const int16_t* data, size_t n);
+uint32_t ZeroCrossings(const int16_t* data, size_t n);
+} // namespace Scalar
+
+} // namespace AudioKernels
+
+#endif // AUDIO_KERNELS_H
@@ -5,56 +5,62 @@
  * 采用 "生产者-消费者" 模型，通过独立的后台线程处理录音和播放，
  * 确保主线程 (UI/状态机) 不会因为音频 I/O 而阻塞。
  * * 核心功能:
- * 1. RecordLoop: 持续从麦克风读取 PCM 数据存入队列 (供 Snowboy/ASR 使用)。
+ * 1. RecordLoop: 持续从麦克风读取 PCM 数据写入共享环形缓冲区，
+ *    各消费者 (Snowboy/VAD/录音文件) 通过 Subscribe() 获得独立游标读取。
  * 2. PlayLoop: 从播放队列取出 PCM 数据写入扬声器 (用于 TTS/音效)。
  * 3. 线程安全: 使用 std::mutex 和 std::condition_variable 保护数据队列。
  * @date 2026-01-16
  */
 
 #include "AudioProcess.h" 
+#include "AudioKernels.h"
+#include "common/config.h"
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <unistd.h>
 #include <algorithm> // for std::fill
+#include <time.h>
+#include <chrono>
 #include <cstring>
 
-// 定义 WAV 文件头偏移量 (44字节)
-#define WAV_HEADER_SIZE 44
-
-struct WavHeader {
-    char riff[4] = {'R', 'I', 'F', 'F'};
-    uint32_t overall_size;      // 文件总大小 - 8
-    char wave[4] = {'W', 'A', 'V', 'E'};
-    char fmt_chunk_marker[4] = {'f', 'm', 't', ' '};
-    uint32_t length_of_fmt = 16;
-    uint16_t format_type = 1;   // 1 = PCM
-    uint16_t channels = 1;      // 单声道 (注意：我们要存的是单声道)
-    uint32_t sample_rate = 16000;
-    uint32_t byterate = 16000 * 16 * 1 / 8; // rate * bits * ch / 8
-    uint16_t block_align = 16 * 1 / 8;      // bits * ch / 8
-    uint16_t bits_per_sample = 16;
-    char data_chunk_header[4] = {'d', 'a', 't', 'a'};
-    uint32_t data_size;         // 纯音频数据大小
-};
+// PlayWavFile 每次从文件读的字节数
+#define WAV_FILE_READ_BYTES 4096
+
+// mmap 模式下等一个周期的超时 (ms)：远大于任何档位的周期，超时说明设备已经不走了
+#define PCM_WAIT_TIMEOUT_MS 1000
+
+// 录音环形缓冲区中留给消费者的最大积压 (ms)，总容量还要加上 AUDIO_PREROLL_MS 的历史
+#define CAPTURE_HEADROOM_MS 2000
 
 // ==========================================
 // 构造与析构
 // ==========================================
 
-AudioProcess::AudioProcess() {
+AudioProcess::AudioProcess()
+    : capture_ring_((CAPTURE_HEADROOM_MS + AUDIO_PREROLL_MS) * 16000 / 1000, 16000),
+      wav_writer_(WAV_WRITER_BUFFER_MS * 16000 / 1000, 16000),
+      utterance_(UTTERANCE_MAX_MS * 16000 / 1000, 16000) {
     // 初始化 PCM 配置
-    // Echo-Mate 硬件需求: 16kHz, 1ch, 16bit
-    memset(&config_, 0, sizeof(config_));
-    config_.channels = 2;
-    config_.rate = 16000;
-    config_.period_size = 1024; // 每次处理约 64ms 数据 (1024/16000)
-    config_.period_count = 4;   // 缓冲区数量
-    config_.format = PCM_FORMAT_S16_LE;
-    
+    // Echo-Mate 硬件需求: 16kHz, 1ch, 16bit (硬件是双声道)；周期大小由档位决定，打开设备时才协商 (OpenPcm)
+    memset(&capture_config_, 0, sizeof(capture_config_));
+    capture_config_.channels = 2;
+    capture_config_.rate = 16000;
+    capture_config_.format = PCM_FORMAT_S16_LE;
+    playback_config_ = capture_config_;
+    SetProfile((Profile)AUDIO_PROFILE);
+    use_mmap_ = AUDIO_MMAP != 0;
+
+    // 双麦合成的历史缓冲区在录音线程打开设备、知道实际周期之后再分配
+    mic_array_.SetMode((MicArray::Mode)AUDIO_MIC_MODE);
+    mic_array_.SetSteeringDelay(AUDIO_BEAM_DELAY_Q8);
+    wav_writer_.SetSyncPolicy((WavWriter::SyncPolicy)WAV_FSYNC_POLICY, WAV_FSYNC_BYTES);
+
     // 初始化静音 (防止爆音)
     system("amixer set 'DAC LINEOUT' 20 > /dev/null 2>&1");
+    record_tap_ = Subscribe("recorder");
     std::cout << "[Audio] Service Constructed (Rate: 16000, Ch: 1)" << std::endl;
 }
 
@@ -67,17 +73,131 @@ AudioProcess::~AudioProcess() {
 // ==========================================
 
 bool AudioProcess::Init() {
-    // 可以在这里做额外的硬件检查，目前直接返回 true
+    // 启动前校验一次 NEON 运算核与标量参考实现是否一致，不一致会自动退回标量版本
+    AudioKernels::SelfTest();
+
+    // 每台设备可以不重新编译就换档位 (比如插电的展示机用 low，电池供电的用 power)
+    const char* env = getenv("ECHO_AUDIO_PROFILE");
+    if (env) {
+        std::string name(env);
+        if (name == "low") SetProfile(kLowLatency);
+        else if (name == "balanced") SetProfile(kBalanced);
+        else if (name == "power") SetProfile(kPowerSave);
+        else printf("[Audio] Unknown ECHO_AUDIO_PROFILE '%s', keeping %s\n", env, ProfileName(profile_));
+    }
+    env = getenv("ECHO_AUDIO_MMAP");
+    if (env) SetMmap(atoi(env) != 0);
+    printf("[Audio] Buffer profile: %s, I/O: %s\n", ProfileName(profile_),
+           use_mmap_ ? "mmap (read/write if unsupported)" : "read/write");
+
+    // 换板子/换驱动后对比一下两种模式的实际开销，再决定 AUDIO_MMAP 怎么设
+    env = getenv("ECHO_AUDIO_BENCH");
+    if (env && atoi(env) > 0) BenchmarkIo((unsigned int)atoi(env));
     return true;
 }
 
+// ==========================================
+// 缓冲区档位 (ALSA 周期配置)
+// ==========================================
+
+namespace {
+
+struct PcmGeometry {
+    unsigned int period_size;   // 单声道样本数 (帧)
+    unsigned int period_count;
+};
+
+// 每个档位的候选，按顺序尝试；都以原来的 1024 x 4 兜底 ({0, 0} 结束)
+// 播放的周期比录音长一些：播放线程每个周期要取一次队列、转双声道，太短容易欠载
+const PcmGeometry kCaptureGeometries[3][5] = {
+    { {160, 4}, {256, 4}, {512, 4}, {1024, 4}, {0, 0} },   // kLowLatency
+    { {320, 4}, {512, 4}, {1024, 4}, {0, 0}, {0, 0} },     // kBalanced
+    { {2048, 4}, {1024, 4}, {0, 0}, {0, 0}, {0, 0} },      // kPowerSave
+};
+const PcmGeometry kPlaybackGeometries[3][5] = {
+    { {256, 4}, {512, 4}, {1024, 4}, {0, 0}, {0, 0} },
+    { {512, 4}, {1024, 4}, {0, 0}, {0, 0}, {0, 0} },
+    { {2048, 4}, {1024, 4}, {0, 0}, {0, 0}, {0, 0} },
+};
+
+}  // namespace
+
+const char* AudioProcess::ProfileName(Profile profile) {
+    switch (profile) {
+        case kLowLatency: return "low-latency";
+        case kBalanced:   return "balanced";
+        case kPowerSave:  return "power-save";
+    }
+    return "?";
+}
+
+void AudioProcess::SetProfile(Profile profile) {
+    if (is_running_.load()) {
+        printf("[Audio] SetProfile ignored: devices are already open\n");
+        return;
+    }
+    if (profile < kLowLatency || profile > kPowerSave) profile = kBalanced;
+    profile_ = profile;
+    // 设备打开之前先按首选的周期报给使用方 (订阅者的默认 hop、播放队列切块)
+    capture_period_.store(kCaptureGeometries[profile][0].period_size);
+    play_period_.store(kPlaybackGeometries[profile][0].period_size);
+}
+
+void AudioProcess::SetMmap(bool enable) {
+    if (is_running_.load()) {
+        printf("[Audio] SetMmap ignored: devices are already open\n");
+        return;
+    }
+    use_mmap_ = enable;
+}
+
+struct pcm* AudioProcess::OpenPcm(unsigned int flags, struct pcm_config& config) {
+    bool capture = (flags & PCM_IN) != 0;
+    const PcmGeometry* candidates = capture ? kCaptureGeometries[profile_] : kPlaybackGeometries[profile_];
+    const char* dir = capture ? ((flags & PCM_MMAP) ? "Capture mmap" : "Capture")
+                              : ((flags & PCM_MMAP) ? "Playback mmap" : "Playback");
+
+    for (int i = 0; i < 5 && candidates[i].period_size; i++) {
+        config.period_size = candidates[i].period_size;
+        config.period_count = candidates[i].period_count;
+        // 阈值交给 tinyalsa 按缓冲区大小重新计算
+        config.start_threshold = 0;
+        config.stop_threshold = 0;
+        struct pcm* pcm = pcm_open(0, 0, flags, &config);
+        if (pcm && pcm_is_ready(pcm)) {
+            // 驱动可能把周期向上取整，后面都按协商的结果来
+            const struct pcm_config* actual = pcm_get_config(pcm);
+            if (actual) {
+                config.period_size = actual->period_size;
+                config.period_count = actual->period_count;
+            }
+            unsigned int period_us = (unsigned int)(config.period_size * 1000000ULL / config.rate);
+            unsigned int buffer_us = period_us * config.period_count;
+            // 录音：一个周期采满才交给 pcm_read，延迟约一个周期；
+            // 播放：pcm_write 会把硬件缓冲区填满，新写入的样本要等前面整个缓冲区播完
+            printf("[Audio] %s (%s): period %u x %u (%u.%u ms, buffer %u.%u ms), latency ~%u ms, %u wakeups/s%s\n",
+                   dir, ProfileName(profile_), config.period_size, config.period_count,
+                   period_us / 1000, period_us / 100 % 10, buffer_us / 1000, buffer_us / 100 % 10,
+                   (capture ? period_us : buffer_us) / 1000, config.rate / config.period_size,
+                   (config.period_size != candidates[i].period_size || config.period_count != candidates[i].period_count)
+                       ? " (adjusted by driver)" : "");
+            return pcm;
+        }
+        printf("[Audio] %s: %u x %u rejected (%s), trying next\n", dir, candidates[i].period_size,
+               candidates[i].period_count, pcm_get_error(pcm));
+        if (pcm) pcm_close(pcm);
+    }
+    return nullptr;
+}
+
 bool AudioProcess::Start() {
     if (is_running_.load()) return true;
 
     is_running_.store(true);
     std::cout << "[Audio] Starting background threads..." << std::endl;
 
-    // 启动录音和播放线程
+    // 启动写文件、录音和播放线程
+    wav_writer_.Start();
     record_thread_ = std::thread(&AudioProcess::RecordLoop, this);
     play_thread_ = std::thread(&AudioProcess::PlayLoop, this);
 
@@ -92,53 +212,71 @@ void AudioProcess::Stop() {
 
     // 唤醒播放线程以便它能退出等待
     playback_cv_.notify_all();
+    capture_cv_.notify_all();
 
     if (record_thread_.joinable()) record_thread_.join();
     if (play_thread_.joinable()) play_thread_.join();
+    // 录音线程已退出，可以安全收尾正在写的文件
+    record_sink_.store(kSinkNone);
+    wav_writer_.Stop();
 
     // 关闭 PCM 句柄
-    if (pcm_in_) {
-        pcm_close(pcm_in_);
-        pcm_in_ = nullptr;
-    }
-    if (pcm_out_) {
-        pcm_close(pcm_out_);
-        pcm_out_ = nullptr;
-    }
+    CloseCapture();
+    ClosePlayback();
+    LogIoStats();
     std::cout << "[Audio] Stopped." << std::endl;
 }
 
 // ==========================================
-// 录音数据接口 (Consumer: IdleState)
+// 录音订阅接口 (Consumer: 唤醒 / VAD / 录音文件)
 // ==========================================
 
-bool AudioProcess::GetFrame(std::vector<int16_t>& chunk) {
-    std::lock_guard<std::mutex> lock(record_mutex_);
-    
-    if (recorded_queue_.empty()) {
-        return false;
-    }
-
-    // 移动语义优化性能
-    chunk = std::move(recorded_queue_.front());
-    recorded_queue_.pop();
-    
-    // 防止队列无限增长 (比如处理太慢时，丢弃旧数据)
-    if (recorded_queue_.size() > 50) {
-        printf("[Audio] Warning: Recording queue overflow, dropping frames!\n");
-        while (recorded_queue_.size() > 10) {
-            recorded_queue_.pop();
+CaptureTap* AudioProcess::Subscribe(const std::string& name, size_t hop) {
+    std::lock_guard<std::mutex> lock(taps_mutex_);
+    for (CaptureTap& tap : taps_) {
+        if (!tap.InUse()) {
+            // 新游标从 "现在" 开始读，不会拿到订阅之前的旧数据
+            tap.Attach(&capture_ring_, name, hop ? hop : PeriodSize());
+            return &tap;
         }
     }
-    
-    return true;
+    printf("[Audio] Error: Too many capture subscribers, cannot add '%s'\n", name.c_str());
+    return nullptr;
+}
+
+void AudioProcess::Unsubscribe(CaptureTap* tap) {
+    if (!tap) return;
+    std::lock_guard<std::mutex> lock(taps_mutex_);
+    tap->Detach();
+}
+
+uint64_t AudioProcess::NowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+uint64_t AudioProcess::ThreadCpuUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+bool AudioProcess::WaitCapture(const CaptureTap* tap, size_t n, unsigned int timeout_ms) {
+    std::unique_lock<std::mutex> lock(capture_mutex_);
+    capture_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                         [&] { return tap->Lag() >= n || !is_running_.load(); });
+    return tap->Lag() >= n;
 }
 
-void AudioProcess::ClearBuff() {
-    std::lock_guard<std::mutex> lock(record_mutex_);
-    std::queue<std::vector<int16_t>> empty;
-    std::swap(recorded_queue_, empty); // 高效清空
-    std::cout << "[Audio] Recorded buffer cleared." << std::endl;
+void AudioProcess::LogTapStats() {
+    std::lock_guard<std::mutex> lock(taps_mutex_);
+    for (const CaptureTap& tap : taps_) {
+        if (!tap.InUse()) continue;
+        printf("[Audio] Tap %-10s lag: %zu, max lag: %zu, dropped: %llu samples (%u overruns)\n",
+               tap.Name().c_str(), tap.Lag(), tap.MaxLag(),
+               (unsigned long long)tap.DroppedSamples(), tap.OverrunCount());
+    }
 }
 
 // ==========================================
@@ -167,90 +305,206 @@ void AudioProcess::PlayWavFile(const std::string& filename) {
     }
     std::cout << "[Audio] Playing: " << filename << std::endl;
     
-    // 跳过 WAV 头
-    fseek(fp, WAV_HEADER_SIZE, SEEK_SET);
+    // 按 WAV 头解析，PCM 和 IMA-ADPCM (存在 Flash 上的压缩回复) 都边读边解码
+    WavStreamParser parser;
+    std::vector<uint8_t> bytes(WAV_FILE_READ_BYTES);
+    std::vector<int16_t> pcm;
 
-    // 计算一个周期的数据量 (以 int16 为单位)
-    size_t chunk_size = config_.period_size * config_.channels;
-    std::vector<int16_t> chunk(chunk_size);
+    // 计算一块的数据量 (以 int16 为单位，两个播放周期)；积压上限按时长算 (约 1 秒)，和周期大小无关
+    size_t chunk_size = play_period_.load() * 2;
+    size_t max_queued = std::max<size_t>(2, 16000 / chunk_size);
 
-    while (is_running_.load() && !feof(fp)) {
-        size_t read_count = fread(chunk.data(), sizeof(int16_t), chunk_size, fp);
-        
-        if (read_count > 0) {
+    while (is_running_.load()) {
+        size_t read_bytes = fread(bytes.data(), 1, bytes.size(), fp);
+        bool eof = read_bytes < bytes.size();
+        if (read_bytes > 0 && !parser.Feed(bytes.data(), read_bytes, pcm)) {
+            std::cerr << "[Audio] Error: Unsupported WAV " << filename << std::endl;
+            break;
+        }
+
+        while (is_running_.load() && (pcm.size() >= chunk_size || (eof && !pcm.empty()))) {
             // 如果读不够一个周期，补零
-            if (read_count < chunk_size) {
-                std::fill(chunk.begin() + read_count, chunk.end(), 0);
-            }
+            std::vector<int16_t> chunk(chunk_size, 0);
+            size_t take = std::min(chunk_size, pcm.size());
+            memcpy(chunk.data(), pcm.data(), take * sizeof(int16_t));
+            pcm.erase(pcm.begin(), pcm.begin() + take);
 
             PutFrame(chunk);
             
             // [简单流控] 防止读文件太快把内存撑爆
-            // 如果队列里积压了超过 0.5秒 的数据 (比如 8 个周期)，就稍微等一下
+            // 如果队列里积压了超过 1 秒的数据，就稍微等一下
             while (is_running_.load()) {
                 size_t queue_size = 0;
                 {
                     std::lock_guard<std::mutex> lock(playback_mutex_);
                     queue_size = playback_queue_.size();
                 }
-                if (queue_size > 8) {
+                if (queue_size > max_queued) {
                     usleep(10000); // 10ms
                 } else {
                     break;
                 }
             }
         }
+        if (eof) break;
     }
 
     fclose(fp);
 }
 
-void AudioProcess::SaveStart(const std::string& filename) {
-    std::lock_guard<std::mutex> lock(file_mutex_);
-    if (record_fp_) fclose(record_fp_);
+void AudioProcess::PlayStreamBegin(unsigned int prefill_ms) {
+    play_parser_.Reset();
+    play_pcm_.clear();
+    size_t period = play_period_.load();
+    play_pcm_.reserve(period * 4);
+    play_stream_samples_.store(0);
+    play_clips_ = 0;
+    // 预缓冲换算成周期数，向上取整
+    size_t prefill_samples = (size_t)prefill_ms * 16000 / 1000;
+    play_prefill_frames_ = (prefill_samples + period - 1) / period;
 
-    record_fp_ = fopen(filename.c_str(), "wb");
-    if (!record_fp_) {
-        printf("[Audio] Error: Cannot create file %s\n", filename.c_str());
-        return;
+    std::lock_guard<std::mutex> lock(playback_mutex_);
+    play_stream_open_ = true;
+    play_gate_ = play_prefill_frames_ > 0;
+    play_underruns_ = 0;
+}
+
+bool AudioProcess::PlayStreamWrite(const void* wav_bytes, size_t size) {
+    bool had_header = play_parser_.HeaderDone();
+    if (!play_parser_.Feed(wav_bytes, size, play_pcm_)) return false;
+
+    if (!had_header && play_parser_.HeaderDone() && play_parser_.SampleRate() != 16000) {
+        printf("[Audio] Warning: stream is %u Hz, playing at %u Hz\n", play_parser_.SampleRate(), 16000u);
     }
+    QueueStreamFrames(false);
+    return true;
+}
 
-    // [关键优化] 先写入 44 字节的空数据占位
-    // 这样我们就可以直接往后追加音频，最后再回来填坑
-    WavHeader dummy_header;
-    fwrite(&dummy_header, sizeof(WavHeader), 1, record_fp_);
+void AudioProcess::PlayStreamNextClip() {
+    play_parser_.Reset();
+    play_clips_++;
+}
 
-    printf("[Audio] Start saving to: %s\n", filename.c_str());
+void AudioProcess::PlayStreamEnd() {
+    QueueStreamFrames(true);
+    unsigned int underruns = 0;
+    {
+        std::lock_guard<std::mutex> lock(playback_mutex_);
+        play_stream_open_ = false;
+        play_gate_ = false;
+        underruns = play_underruns_;
+    }
+    playback_cv_.notify_one();
+    if (play_clips_ > 0) printf("[Audio] Reply stream: %u clips, %u underruns\n", play_clips_, underruns);
 }
 
-void AudioProcess::SaveStop() {
+bool AudioProcess::PlayStreamSink(const void* wav_bytes, size_t size, void* self) {
+    return ((AudioProcess*)self)->PlayStreamWrite(wav_bytes, size);
+}
+
+void AudioProcess::PlayStreamFinish(void* self) {
+    ((AudioProcess*)self)->PlayStreamEnd();
+}
+
+void AudioProcess::PlayStreamClip(void* self) {
+    ((AudioProcess*)self)->PlayStreamNextClip();
+}
+
+void AudioProcess::QueueStreamFrames(bool flush) {
+    size_t period = play_period_.load();
+    size_t used = 0;
+    bool opened = false;
+    {
+        std::lock_guard<std::mutex> lock(playback_mutex_);
+        while (play_pcm_.size() - used >= period || (flush && used < play_pcm_.size())) {
+            // 最后不满一个周期的部分补零
+            size_t n = std::min(period, play_pcm_.size() - used);
+            std::vector<int16_t> frame(period, 0);
+            memcpy(frame.data(), play_pcm_.data() + used, n * sizeof(int16_t));
+            playback_queue_.push(std::move(frame));
+            used += n;
+        }
+        if (play_gate_ && playback_queue_.size() >= play_prefill_frames_) {
+            play_gate_ = false;
+            opened = true;
+        }
+    }
+    play_stream_samples_ += used;
+    play_pcm_.erase(play_pcm_.begin(), play_pcm_.begin() + used);
+    if (used || opened) playback_cv_.notify_one();
+}
+
+void AudioProcess::SaveStart(const std::string& filename, uint64_t start_time_us) {
     std::lock_guard<std::mutex> lock(file_mutex_);
-    if (!record_fp_) return;
+    StopRecorder();
+    // 已有的文件会在 Open 里先被关闭
+    if (!wav_writer_.Open(filename)) return;
 
-    // 1. 获取文件总大小
-    fseek(record_fp_, 0, SEEK_END);
-    long file_size = ftell(record_fp_);
-    
-    // 2. 计算数据大小 (总大小 - 44字节头)
-    long data_size = file_size - sizeof(WavHeader);
-    if (data_size < 0) data_size = 0;
+    StartRecorder(kSinkFile, start_time_us);
+    printf("[Audio] Start saving to: %s (pre-roll: %zu samples)\n", filename.c_str(), record_tap_->Lag());
+}
 
-    // 3. 回到文件开头，准备重写头
-    fseek(record_fp_, 0, SEEK_SET);
+void AudioProcess::SaveStop() {
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    if (!wav_writer_.IsOpen()) return;
 
-    // 4. 填充真正的 WAV 头
-    WavHeader header;
-    header.data_size = (uint32_t)data_size;
-    header.overall_size = header.data_size + 36;
-    
-    // 5. 覆盖写入头
-    fwrite(&header, sizeof(WavHeader), 1, record_fp_);
+    if (record_sink_.load() == kSinkFile) StopRecorder();
+    // 写完剩余数据并回填 WAV 头 (在 WavWriter 里完成)
+    long file_size = wav_writer_.Close();
 
-    // 6. 关闭文件
-    fclose(record_fp_);
-    record_fp_ = nullptr;
-    
     printf("[Audio] Recording saved. (Size: %ld bytes)\n", file_size);
+    wav_writer_.LogStats();
+}
+
+void AudioProcess::UtteranceStart(uint64_t start_time_us) {
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    StopRecorder();
+    if (wav_writer_.IsOpen()) wav_writer_.Close();
+    utterance_.Reset();
+
+    StartRecorder(kSinkMemory, start_time_us);
+    printf("[Audio] Start recording to memory (pre-roll: %zu samples)\n", record_tap_->Lag());
+}
+
+const UtteranceBuffer& AudioProcess::UtteranceStop() {
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    if (record_sink_.load() == kSinkMemory) StopRecorder();
+    utterance_.Finish();
+
+    printf("[Audio] Utterance recorded. (%zu samples, %zu bytes, dropped: %llu)\n",
+           utterance_.Samples(), utterance_.WavSize(), (unsigned long long)utterance_.DroppedSamples());
+    return utterance_;
+}
+
+void AudioProcess::StartRecorder(RecordSink sink, uint64_t start_time_us) {
+    // 录音线程已不再碰 record_tap_，这里可以安全地移动它
+    // 录音游标跳到起始位置：默认从现在开始，否则回到历史中的指定时刻 (pre-roll)
+    if (start_time_us) {
+        record_tap_->SeekToTime(start_time_us);
+    } else {
+        record_tap_->Clear();
+    }
+    record_hold_pos_.store(UINT64_MAX);
+    record_resume_pos_.store(0);
+    record_sink_.store(sink);
+}
+
+void AudioProcess::RecordHold(uint64_t pos) {
+    record_hold_pos_.store(pos);
+}
+
+void AudioProcess::RecordResume(uint64_t pos) {
+    // 游标只能由录音线程移动，这里只留个位置，下一次 DrainRecorder 时跳过去
+    record_resume_pos_.store(pos ? pos : 1);
+}
+
+void AudioProcess::StopRecorder() {
+    // 先关掉开关，再等录音线程离开 DrainRecorder；之后 record_tap_ 归控制线程所有
+    // (两边都用 seq_cst 原子操作，保证不会同时看到对方的旧值)
+    record_sink_.store(kSinkNone);
+    while (record_busy_.load()) {
+        usleep(1000);
+    }
 }
 
 // ==========================================
@@ -258,77 +512,218 @@ void AudioProcess::SaveStop() {
 // ==========================================
 
 void AudioProcess::RecordLoop() {
-    printf("[Audio] Capture Thread Started (Hardware: 2ch -> Software: 1ch).\n");
-    
-    // [适配 RV1106] 硬件必须开启双声道，否则报 Error -22
-    config_.channels = 2;
-
-    // 打开录音设备 (card 0, device 0)
-    pcm_in_ = pcm_open(0, 0, PCM_IN, &config_);
+    printf("[Audio] Capture Thread Started (Hardware: 2ch -> Software: 1ch, mic mode: %s).\n",
+           MicArray::ModeName(mic_array_.GetMode()));
 
-    if (!pcm_in_ || !pcm_is_ready(pcm_in_)) {
-        printf("[Audio] Error opening Capture: %s\n", pcm_get_error(pcm_in_));
-        if (pcm_in_) pcm_close(pcm_in_);
+    // 打开录音设备 (card 0, device 0)，按档位依次尝试周期配置
+    if (!OpenCapture(use_mmap_)) {
+        printf("[Audio] Error opening Capture: no period configuration accepted\n");
         return;
     }
 
-    // 计算 buffer 大小
-    // 注意：因为硬件是双声道，所以读取的帧数对应的字节数是单声道的2倍
-    int stereo_frame_count = config_.period_size;
-    int stereo_buffer_bytes = pcm_frames_to_bytes(pcm_in_, stereo_frame_count);
-    
-    // 1. 临时存储从硬件读来的【双声道】原生数据
-    std::vector<int16_t> stereo_buffer(stereo_frame_count * 2); // size * 2 channels
-    
-    // 2. 准备一个容器存储转换后的【单声道】数据
-    std::vector<int16_t> mono_buffer(stereo_frame_count);       // size * 1 channel
+    // 读写模式的中转缓存：硬件读来的【双声道】原生数据和合成后的【单声道】数据
+    // (按周期在 CaptureOnce 里调整大小，之后不再分配；mmap 模式用不到)
+    std::vector<int16_t> stereo_buffer;
+    std::vector<int16_t> mono_buffer;
+    uint64_t cpu_start = ThreadCpuUs();
 
-    int counter = 0; // 计数器
     while (is_running_.load()) {
-        // pcm_read 是阻塞的，读取双声道数据 (L, R, L, R...)
-        int ret = pcm_read(pcm_in_, stereo_buffer.data(), stereo_buffer_bytes);
-        
+        // 上次重新打开失败了，过一会儿再试
+        if (!pcm_in_) {
+            usleep(20000);
+            OpenCapture(use_mmap_);
+            continue;
+        }
+
+        int ret = CaptureOnce(stereo_buffer, mono_buffer);
+
         if (ret >= 0) {
-            // --- [软件转换：双声道 -> 单声道] ---
-            // 我们只需要左声道数据 (Left Channel)，丢弃右声道
-            for (int i = 0; i < stereo_frame_count; ++i) {
-                mono_buffer[i] = stereo_buffer[2 * i]; // 取偶数位索引
-            }
-            
-            // [新增] 如果开启了文件录制，把单声道数据写入文件
-            {
-                std::lock_guard<std::mutex> lock(file_mutex_);
-                if (record_fp_) {
-                    fwrite(mono_buffer.data(), sizeof(int16_t), mono_buffer.size(), record_fp_);
-                }
-            }
+            capture_samples_ += ret;
+            capture_cpu_us_.store(ThreadCpuUs() - cpu_start);
+
+            // 叫醒在 WaitCapture 里等数据的消费者 (先过一下锁，避免和它们的判断错开而漏掉通知)
+            { std::lock_guard<std::mutex> lock(capture_mutex_); }
+            capture_cv_.notify_all();
 
-            // 成功读取并转换，放入队列 (Snowboy 需要单声道)
-            std::lock_guard<std::mutex> lock(record_mutex_);
-            recorded_queue_.push(mono_buffer);
+            // 如果开启了文件录制，把录音游标上的新数据交给后台写文件线程
+            DrainRecorder();
         } else {
             // --- [核心修复] 错误处理与恢复 ---
-            
-            // 1. 打印具体的错误码 (ret 通常返回 -1, 需要看 errno, 或者 pcm_read 返回的就是负的错误码)
-            // TinyALSA 的 pcm_read 出错时通常返回 -1，具体错误在 errno 中；或者直接返回负数
+
+            // 1. 打印具体的错误码 (TinyALSA 出错时返回负的错误码，详细信息在 pcm_get_error 里)
             printf("[Audio] Capture failed! ret: %d, Msg: %s\n", ret, pcm_get_error(pcm_in_));
 
-            // 2. 尝试处理 XRUN (Broken Pipe)
-            // 如果是因为缓冲区溢出 (EPIPE)，我们需要重新 prepare 声卡
-            if (pcm_is_ready(pcm_in_)) {
-                printf("[Audio] Recovering from XRUN...\n");
-                pcm_prepare(pcm_in_);
+            // 2. 尝试处理 XRUN (Broken Pipe)，声卡彻底挂了就重新 open
+            RecoverCapture();
+
+            // 3. 避免死循环刷屏，稍微睡一下
+            usleep(20000);
+        }
+    }
+}
+
+bool AudioProcess::OpenCapture(bool mmap) {
+    // [适配 RV1106] 硬件必须开启双声道，否则报 Error -22
+    capture_config_.channels = 2;
+
+    pcm_in_ = nullptr;
+    if (mmap) {
+        // PCM_MONOTONIC：硬件时间戳和 NowUs() 是同一个时钟，直接拿来当时间锚点
+        pcm_in_ = OpenPcm(PCM_IN | PCM_MMAP | PCM_MONOTONIC, capture_config_);
+        // mmap 模式没有 pcm_read 替我们启动，打开后马上开始采集
+        if (pcm_in_ && pcm_start(pcm_in_) < 0) {
+            printf("[Audio] Capture mmap start failed (%s)\n", pcm_get_error(pcm_in_));
+            pcm_close(pcm_in_);
+            pcm_in_ = nullptr;
+        }
+        if (!pcm_in_) printf("[Audio] Capture: mmap unavailable, falling back to read/write\n");
+    }
+    bool mapped = pcm_in_ != nullptr;
+    if (!pcm_in_) pcm_in_ = OpenPcm(PCM_IN, capture_config_);
+    if (!pcm_in_) return false;
+
+    capture_mmap_.store(mapped);
+    capture_period_.store(capture_config_.period_size);
+    // 双麦合成：历史缓冲区按一个周期预分配，循环里不再分配
+    mic_array_.Configure(capture_config_.period_size);
+    return true;
+}
+
+void AudioProcess::CloseCapture() {
+    if (pcm_in_) {
+        pcm_close(pcm_in_);
+        pcm_in_ = nullptr;
+    }
+}
+
+int AudioProcess::CaptureOnce(std::vector<int16_t>& stereo, std::vector<int16_t>& mono) {
+    if (capture_mmap_.load()) return CaptureMmapOnce();
+
+    // 注意：因为硬件是双声道，所以读取的帧数对应的字节数是单声道的2倍
+    size_t frames = capture_config_.period_size;
+    stereo.resize(frames * 2);
+    mono.resize(frames);
+
+    // pcm_read 是阻塞的，读取双声道数据 (L, R, L, R...)
+    int ret = pcm_read(pcm_in_, stereo.data(), pcm_frames_to_bytes(pcm_in_, frames));
+    if (ret < 0) return ret;
+
+    // --- [软件转换：双声道 -> 单声道] ---
+    // 两路麦克风按当前模式合成一路 (平均 / 延迟求和 / 只取左声道)
+    mic_array_.Process(stereo.data(), mono.data(), frames);
+
+    // 先跑 VAD 再写环形缓冲区：消费者读到这段数据时，它的 VAD 结果已经可以查了
+    // (待机时也一直在跑，噪声底在唤醒之前就估计好了)
+    vad_.Process(mono.data(), frames, capture_ring_.WritePos());
+
+    // 成功读取并转换，写入共享环形缓冲区 (Snowboy 需要单声道)
+    // 写者永不阻塞：跟不上的订阅者会在自己的统计里记下丢帧
+    // pcm_read 返回时刻即为本周期最后一个样本的采集时间
+    capture_ring_.Write(mono.data(), frames, NowUs());
+    return (int)frames;
+}
+
+int AudioProcess::CaptureMmapOnce() {
+    // 1. 等至少一个周期采满 (poll，不拷贝)
+    int ret = pcm_wait(pcm_in_, PCM_WAIT_TIMEOUT_MS);
+    if (ret == 0) return -ETIMEDOUT;
+    if (ret < 0) return ret;
+
+    // 2. 同步硬件指针：可读的帧数 + 硬件指针更新时的时间戳 (即最新一帧的采集时间)
+    //    流不在 RUNNING 状态 (XRUN) 时返回 -1
+    unsigned int avail = 0;
+    struct timespec ts;
+    if (pcm_get_htimestamp(pcm_in_, &avail, &ts) < 0) return -EPIPE;
+    uint64_t end_us = (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+
+    const size_t channels = capture_config_.channels;
+    int total = 0;
+    while (avail > 0) {
+        // 3. DMA 缓冲区里连续的一段 (到缓冲区末尾为止)，一次不超过一个周期 (MicArray 按周期预分配)
+        void* areas = nullptr;
+        unsigned int offset = 0;
+        unsigned int frames = std::min<unsigned int>(avail, capture_config_.period_size);
+        ret = pcm_mmap_begin(pcm_in_, &areas, &offset, &frames);
+        if (ret < 0) return ret;
+        if (frames == 0) break;
+        const int16_t* dma = (const int16_t*)areas + (size_t)offset * channels;
+
+        // 4. 两路麦克风直接合成进录音环形缓冲区 (回绕处分两段)，发布之前就地跑 VAD
+        int16_t* part[2];
+        size_t len[2];
+        uint64_t pos = capture_ring_.BeginWrite(frames, part, len);
+        for (int i = 0; i < 2; i++) {
+            if (!len[i]) continue;
+            mic_array_.Process(dma, part[i], len[i]);
+            vad_.Process(part[i], len[i], pos);
+            dma += len[i] * channels;
+            pos += len[i];
+        }
+        // 这一段最后一帧的采集时间：时间戳对应的是最新一帧，往回减掉后面还没取的帧
+        avail -= frames;
+        capture_ring_.CommitWrite(frames, end_us - (uint64_t)avail * 1000000ULL / capture_config_.rate);
+
+        // 5. 这段 DMA 缓冲区还给驱动
+        ret = pcm_mmap_commit(pcm_in_, offset, frames);
+        if (ret < 0) return ret;
+        total += (int)frames;
+    }
+    return total;
+}
+
+void AudioProcess::RecoverCapture() {
+    if (pcm_is_ready(pcm_in_)) {
+        // 如果是因为缓冲区溢出 (EPIPE)，我们需要重新 prepare 声卡
+        printf("[Audio] Recovering from XRUN...\n");
+        if (capture_mmap_.load()) {
+            // mmap 模式没有 pcm_read 帮忙重启：先停下 (下次 prepare 才会真正执行)，再 prepare + start
+            pcm_stop(pcm_in_);
+            pcm_start(pcm_in_);
+        } else {
+            pcm_prepare(pcm_in_);
+        }
+    } else {
+        // 如果声卡彻底挂了，尝试重新 open (这是最后的手段)，按原来的模式
+        printf("[Audio] Sound card not ready, trying to reopen...\n");
+        bool mmap = capture_mmap_.load();
+        CloseCapture();
+        OpenCapture(mmap);
+    }
+}
+
+void AudioProcess::DrainRecorder() {
+    // 只做一次 memcpy：积压的数据直接从环形缓冲区 (视图) 拷到 WavWriter 或内存录音的缓冲区，
+    // 不经过中间缓存，不碰文件、不加锁
+    record_busy_.store(true);
+    int sink = record_sink_.load();
+    CaptureView view;
+    size_t n = 0;
+    if (sink != kSinkNone) {
+        // RecordResume：跳过暂停期间的音频，取消暂停
+        uint64_t resume = record_resume_pos_.exchange(0);
+        if (resume) {
+            record_hold_pos_.store(UINT64_MAX);
+            record_tap_->Seek(resume);
+        }
+        // RecordHold：只录到暂停的位置
+        n = record_tap_->Lag();
+        uint64_t hold = record_hold_pos_.load();
+        uint64_t pos = record_tap_->Position();
+        if (hold != UINT64_MAX) n = hold > pos ? (size_t)std::min<uint64_t>(n, hold - pos) : 0;
+    }
+    if (n > 0 && record_tap_->Peek(n, view)) {
+        for (int i = 0; i < 2; i++) {
+            if (!view.len[i]) continue;
+            if (sink == kSinkFile) {
+                wav_writer_.Push(view.part[i], view.len[i]);
             } else {
-                // 如果声卡彻底挂了，尝试重新 open (这是最后的手段)
-                printf("[Audio] Sound card not ready, trying to reopen...\n");
-                pcm_close(pcm_in_);
-                pcm_in_ = pcm_open(0, 0, PCM_IN, &config_);
+                utterance_.Append(view.part[i], view.len[i]);
             }
-            
-            // 3. 避免死循环刷屏，稍微睡一下
-            usleep(20000); 
         }
+        // 录音线程自己就是写者，拷贝期间不会被覆盖
+        record_tap_->Consume(view);
     }
+    record_busy_.store(false);
 }
 
 // ... (前面的构造、析构、Init、Start、Stop 保持不变) ...
@@ -344,52 +739,247 @@ double AudioProcess::CalculateRMS(const std::vector<int16_t>& data) {
     return std::sqrt(sum / data.size());
 }
 
-// 判断是否正在播放：只要队列里还有数据，就认为还没播完
+// 判断是否正在播放：只要队列里还有数据，或者流式播放还没结束，就认为还没播完
 bool AudioProcess::IsPlaying() {
     std::lock_guard<std::mutex> lock(playback_mutex_);
-    return !playback_queue_.empty();
+    return !playback_queue_.empty() || play_stream_open_;
 }
 
 // [修改] PlayLoop 逻辑微调
 void AudioProcess::PlayLoop() {
     printf("[Audio] Playback Thread Started (Software: 1ch -> Hardware: 2ch).\n");
 
-    config_.channels = 2; // 硬件双声道
-    pcm_out_ = pcm_open(0, 0, PCM_OUT, &config_);
-
-    if (!pcm_out_ || !pcm_is_ready(pcm_out_)) {
-        printf("[Audio] Error opening Playback: %s\n", pcm_get_error(pcm_out_));
-        if (pcm_out_) pcm_close(pcm_out_);
+    if (!OpenPlayback(use_mmap_)) {
+        printf("[Audio] Error opening Playback: no period configuration accepted\n");
         return;
     }
 
+    // 两个缓冲区都在循环外分配并复用，播放过程中不再有堆分配 (mmap 模式不需要 stereo_frame)
+    std::vector<int16_t> mono_frame;
+    std::vector<int16_t> stereo_frame;
+    stereo_frame.reserve(playback_config_.period_size * playback_config_.channels * 2);
+    uint64_t cpu_start = ThreadCpuUs();
+
     while (is_running_.load()) {
-        std::vector<int16_t> mono_frame;
-        
+        bool last = false;
         {
             std::unique_lock<std::mutex> lock(playback_mutex_);
             playback_cv_.wait(lock, [this] {
-                return !playback_queue_.empty() || !is_running_.load();
+                // 流式播放预缓冲期间 (play_gate_) 先不取数据
+                return (!playback_queue_.empty() && !play_gate_) || !is_running_.load();
             });
 
             if (!is_running_.load()) break;
 
-            mono_frame = playback_queue_.front();
+            // swap 取走数据，不拷贝
+            mono_frame.swap(playback_queue_.front());
             playback_queue_.pop();
+            last = playback_queue_.empty();
+            if (last && play_stream_open_) play_underruns_++;
         }
 
-        // 双声道转换
-        std::vector<int16_t> stereo_frame(mono_frame.size() * 2);
-        for (size_t i = 0; i < mono_frame.size(); ++i) {
-            stereo_frame[2 * i]     = mono_frame[i]; 
-            stereo_frame[2 * i + 1] = mono_frame[i]; 
-        }
+        // 写入硬件 (缓冲区满时阻塞，约一个周期)
+        int ret = PlaybackWrite(mono_frame.data(), mono_frame.size(), stereo_frame, last);
 
-        // 写入硬件 (这一步是耗时的，约 64ms)
-        int ret = pcm_write(pcm_out_, stereo_frame.data(), stereo_frame.size() * sizeof(int16_t));
-        
         if (ret < 0) {
-             printf("[Audio] Playback write error: %s\n", pcm_get_error(pcm_out_));
+            printf("[Audio] Playback write error: %d (%s)\n", ret, pcm_get_error(pcm_out_));
+            RecoverPlayback();
+        } else {
+            play_samples_ += mono_frame.size();
+            play_cpu_us_.store(ThreadCpuUs() - cpu_start);
+        }
+    }
+}
+
+bool AudioProcess::OpenPlayback(bool mmap) {
+    playback_config_.channels = 2; // 硬件双声道
+
+    pcm_out_ = nullptr;
+    if (mmap) {
+        pcm_out_ = OpenPcm(PCM_OUT | PCM_MMAP, playback_config_);
+        if (!pcm_out_) printf("[Audio] Playback: mmap unavailable, falling back to read/write\n");
+    }
+    bool mapped = pcm_out_ != nullptr;
+    if (!pcm_out_) pcm_out_ = OpenPcm(PCM_OUT, playback_config_);
+    if (!pcm_out_) return false;
+
+    playback_mmap_.store(mapped);
+    playback_started_ = false;
+    // mmap 模式先 prepare 好再往缓冲区里写，之后 pcm_start 不会再 prepare 一次把写好的数据清掉
+    if (mapped) pcm_prepare(pcm_out_);
+    // 之后进队列的数据按协商后的周期切块 (已经在队列里的块大小不同也能正常播放)
+    play_period_.store(playback_config_.period_size);
+    play_buffer_.store(playback_config_.period_size * playback_config_.period_count);
+    return true;
+}
+
+void AudioProcess::ClosePlayback() {
+    if (pcm_out_) {
+        pcm_close(pcm_out_);
+        pcm_out_ = nullptr;
+    }
+}
+
+int AudioProcess::PlaybackWrite(const int16_t* mono, size_t n, std::vector<int16_t>& stereo, bool last) {
+    if (playback_mmap_.load()) return PlaybackMmapWrite(mono, n, last);
+
+    // 双声道转换 (NEON 加速，容量足够时 resize 不会重新分配)
+    stereo.resize(n * 2);
+    AudioKernels::Duplicate(mono, stereo.data(), n);
+    return pcm_write(pcm_out_, stereo.data(), stereo.size() * sizeof(int16_t));
+}
+
+int AudioProcess::PlaybackMmapWrite(const int16_t* mono, size_t n, bool last) {
+    unsigned int avail = 0;
+    struct timespec ts;
+    // 播放队列空了一阵之后流已经欠载停下 (stop_threshold = 缓冲区大小)：重新 prepare，从头填
+    if (playback_started_ && pcm_get_htimestamp(pcm_out_, &avail, &ts) < 0) RecoverPlayback();
+
+    const size_t channels = playback_config_.channels;
+    size_t done = 0;
+    while (done < n) {
+        void* areas = nullptr;
+        unsigned int offset = 0;
+        unsigned int frames = (unsigned int)(n - done);
+        int ret = pcm_mmap_begin(pcm_out_, &areas, &offset, &frames);
+        if (ret < 0) return ret;
+
+        if (frames == 0) {
+            // 缓冲区满了：还没开始播就现在开始，否则等硬件播掉一个周期
+            if (!playback_started_) {
+                ret = pcm_start(pcm_out_);
+                if (ret < 0) return ret;
+                playback_started_ = true;
+                continue;
+            }
+            ret = pcm_wait(pcm_out_, PCM_WAIT_TIMEOUT_MS);
+            if (ret == 0) return -ETIMEDOUT;
+            if (ret < 0) return ret;
+            // 同步硬件指针 (status 页没有映射的平台上，pcm_mmap_begin 看到的还是上次同步的位置)
+            if (pcm_get_htimestamp(pcm_out_, &avail, &ts) < 0) return -EPIPE;
+            continue;
+        }
+
+        // 单声道直接复制成双声道写进 DMA 缓冲区，没有中间缓存
+        AudioKernels::Duplicate(mono + done, (int16_t*)areas + (size_t)offset * channels, frames);
+        ret = pcm_mmap_commit(pcm_out_, offset, frames);
+        if (ret < 0) return ret;
+        done += frames;
+    }
+
+    // 后面暂时没有数据了：缓冲区没填满也要开始播，不然短提示音一直不出声
+    if (last && !playback_started_) {
+        int ret = pcm_start(pcm_out_);
+        if (ret < 0) return ret;
+        playback_started_ = true;
+    }
+    return (int)n;
+}
+
+void AudioProcess::RecoverPlayback() {
+    // 读写模式下 pcm_write 下一次写入时会自己重新 prepare
+    if (!playback_mmap_.load()) return;
+    // 先停下 (pcm_prepare 才会真正执行)，回到 PREPARED，等缓冲区重新填满再开始
+    pcm_stop(pcm_out_);
+    pcm_prepare(pcm_out_);
+    playback_started_ = false;
+}
+
+// ==========================================
+// CPU 开销统计 (读写模式 vs mmap 模式)
+// ==========================================
+
+void AudioProcess::LogIoStats() {
+    struct {
+        const char* dir;
+        bool mmap;
+        uint64_t cpu_us;
+        uint64_t samples;
+    } rows[2] = {
+        { "Capture", capture_mmap_.load(), capture_cpu_us_.load(), capture_samples_.load() },
+        { "Playback", playback_mmap_.load(), play_cpu_us_.load(), play_samples_.load() },
+    };
+    for (const auto& row : rows) {
+        if (!row.samples) continue;
+        // 每秒音频的 CPU 时间 (ms)：cpu_us / 1000 / (samples / 16000)
+        printf("[Audio] %s (%s): %.2f ms CPU per s audio (%.1f s audio)\n", row.dir,
+               row.mmap ? "mmap" : "read/write", row.cpu_us * 16.0 / row.samples, row.samples / 16000.0);
+    }
+}
+
+void AudioProcess::BenchmarkIo(unsigned int seconds) {
+    if (is_running_.load()) {
+        printf("[Audio] BenchmarkIo ignored: devices are already open\n");
+        return;
+    }
+    const size_t target = (size_t)seconds * 16000;
+    printf("[Audio] I/O benchmark: %u s per mode (capture: live mics, playback: silence)\n", seconds);
+
+    // [方向][模式] 每秒音频的 CPU 时间 (ms)，< 0 表示没测成
+    double result[2][2] = { { -1, -1 }, { -1, -1 } };
+
+    for (int m = 0; m < 2; m++) {
+        bool mmap = m == 1;
+
+        // --- 录音：和 RecordLoop 一样，合成 + VAD + 写环形缓冲区都算在内 ---
+        if (OpenCapture(mmap)) {
+            if (capture_mmap_.load() == mmap) {
+                std::vector<int16_t> stereo, mono;
+                size_t samples = 0;
+                unsigned int errors = 0;
+                uint64_t cpu_start = ThreadCpuUs();
+                while (samples < target && errors < 10) {
+                    int ret = CaptureOnce(stereo, mono);
+                    if (ret < 0) {
+                        errors++;
+                        RecoverCapture();
+                        if (!pcm_in_) break;
+                        continue;
+                    }
+                    samples += ret;
+                }
+                if (samples) result[0][m] = (ThreadCpuUs() - cpu_start) * 16.0 / samples;
+            }
+            CloseCapture();
         }
+
+        // --- 播放：按协商的周期写静音，和 PlayLoop 一样包含双声道转换 ---
+        if (OpenPlayback(mmap)) {
+            if (playback_mmap_.load() == mmap) {
+                std::vector<int16_t> silence(playback_config_.period_size, 0);
+                std::vector<int16_t> stereo;
+                size_t samples = 0;
+                unsigned int errors = 0;
+                uint64_t cpu_start = ThreadCpuUs();
+                while (samples < target && errors < 10) {
+                    int ret = PlaybackWrite(silence.data(), silence.size(), stereo, false);
+                    if (ret < 0) {
+                        errors++;
+                        RecoverPlayback();
+                        continue;
+                    }
+                    samples += silence.size();
+                }
+                if (samples) result[1][m] = (ThreadCpuUs() - cpu_start) * 16.0 / samples;
+            }
+            ClosePlayback();
+        }
+    }
+
+    const char* dirs[2] = { "capture", "playback" };
+    for (int d = 0; d < 2; d++) {
+        if (result[d][0] < 0 && result[d][1] < 0) {
+            printf("[Audio] Bench %-8s: device unavailable\n", dirs[d]);
+            continue;
+        }
+        if (result[d][0] < 0 || result[d][1] < 0) {
+            // 某个模式打不开/没跑成，只报测到的那个
+            printf("[Audio] Bench %-8s: %s %.2f ms CPU per s audio, %s unavailable\n", dirs[d],
+                   result[d][0] < 0 ? "mmap" : "read/write", std::max(result[d][0], result[d][1]),
+                   result[d][0] < 0 ? "read/write" : "mmap");
+            continue;
+        }
+        printf("[Audio] Bench %-8s: read/write %.2f ms, mmap %.2f ms CPU per s audio (%+.0f%%)\n", dirs[d],
+               result[d][0], result[d][1], result[d][0] > 0 ? (result[d][1] / result[d][0] - 1) * 100 : 0.0);
     }
-}
\ No newline at end of file
+}
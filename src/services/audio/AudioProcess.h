@@ -13,8 +13,27 @@
 // TinyALSA 头文件
 #include <tinyalsa/asoundlib.h>
 
+#include "CaptureRing.h"
+#include "MicArray.h"
+#include "WavWriter.h"
+#include "UtteranceBuffer.h"
+#include "VadEngine.h"
+#include "WavStreamParser.h"
+
+// 同时存在的录音订阅者上限 (唤醒、VAD、录音文件、电平表...)
+#define MAX_CAPTURE_TAPS 8
+
 class AudioProcess {
 public:
+    // ALSA 缓冲区配置档位：周期越短延迟越低，但每秒唤醒次数 (中断 + 线程切换) 越多
+    // 每个档位有一串候选 (周期样本数 x 周期数)，pcm_open 不接受时依次退回，最后一个是原来的 1024 x 4
+    enum Profile {
+        kLowLatency = 0,  // 录音 10ms x 4，播放 16ms x 4
+        kBalanced = 1,    // 录音 20ms x 4，播放 32ms x 4
+        kPowerSave = 2,   // 录音/播放 128ms x 4
+    };
+    static const char* ProfileName(Profile profile);
+
     // 单例模式
     static AudioProcess& GetInstance() {
         static AudioProcess instance;
@@ -25,22 +44,99 @@ public:
     AudioProcess(const AudioProcess&) = delete;
     void operator=(const AudioProcess&) = delete;
 
+    // Init 时读取环境变量 ECHO_AUDIO_PROFILE (low / balanced / power)，没有则用 AUDIO_PROFILE；
+    // ECHO_AUDIO_MMAP=0/1 覆盖 AUDIO_MMAP；设置了 ECHO_AUDIO_BENCH=<秒> 时先跑一遍 BenchmarkIo
     bool Init();
     bool Start();
     void Stop();
 
-    // 录音接口
-    bool GetFrame(std::vector<int16_t>& chunk);
-    void ClearBuff();
-    void SaveStart(const std::string& filename);
+    // 选择缓冲区档位，只在 Start() 之前有效 (设备打开时才按它协商)
+    void SetProfile(Profile profile);
+    Profile GetProfile() const { return profile_; }
+
+    // mmap 模式：录音直接从 DMA 缓冲区合成到录音环形缓冲区，播放直接把双声道样本写进硬件缓冲区，
+    // 省掉 pcm_read/pcm_write 在内核和用户态之间的拷贝以及中间缓存。只在 Start() 之前有效；
+    // 驱动不支持 mmap 时自动退回读写模式 (Capture/PlaybackMmap() 是实际用上的模式)
+    void SetMmap(bool enable);
+    bool CaptureMmap() const { return capture_mmap_.load(); }
+    bool PlaybackMmap() const { return playback_mmap_.load(); }
+    // 对比两种模式的 CPU 开销：录音和播放各自先用读写模式、再用 mmap 模式跑 seconds 秒
+    // (录真实的麦克风，播静音)，打印每秒音频花掉的 CPU 时间。设备被占用，只能在 Start() 之前调用
+    void BenchmarkIo(unsigned int seconds);
+    // 打印录音/播放线程每秒音频的 CPU 时间 (Stop 时也会打印)
+    void LogIoStats();
+
+    // 录音订阅接口：每个消费者拿到自己的读游标，音频只存一份
+    // hop: 这个消费者每次处理多少样本 (CaptureTap::Peek 的默认长度)，0 表示一个 ALSA 周期；和周期大小无关
+    // 返回 nullptr 表示订阅者已满；用完必须 Unsubscribe
+    CaptureTap* Subscribe(const std::string& name, size_t hop = 0);
+    void Unsubscribe(CaptureTap* tap);
+    // 单声道一个 ALSA 周期的样本数 (消费者一般按这个粒度读取)
+    // 设备打开之前是档位里首选的周期，打开之后是和驱动协商出来的
+    size_t PeriodSize() const { return capture_period_.load(); }
+    // 打印所有订阅者的积压/丢帧统计
+    void LogTapStats();
+    // 阻塞到 tap 上至少有 n 个未读样本 (录音线程每写入一个周期唤醒一次)，超时返回 false
+    // 给有自己线程的消费者用 (唤醒词检测)，不用轮询 sleep
+    bool WaitCapture(const CaptureTap* tap, size_t n, unsigned int timeout_ms);
+    // 录音线程对每个周期都跑了一遍 VAD；[begin, end) 是录音位置 (游标的 Position())
+    // 消费者读完一帧后查这一帧的语音概率，不用自己再算能量
+    bool VadQuery(uint64_t begin, uint64_t end, VadResult& out) const { return vad_.Query(begin, end, out); }
+    const VadEngine& Vad() const { return vad_; }
+
+    // 双麦合成方式，可随时切换，下一个录音周期生效
+    void SetMicMode(MicArray::Mode mode) { mic_array_.SetMode(mode); }
+    MicArray::Mode GetMicMode() const { return mic_array_.GetMode(); }
+    // 延迟求和波束的指向 (见 MicArray::SetSteeringDelay)
+    void SetBeamDelay(int32_t delay_q8) { mic_array_.SetSteeringDelay(delay_q8); }
+
+    // 录音时间轴 (CLOCK_MONOTONIC 微秒)，用于按时间回看历史音频 (pre-roll)
+    static uint64_t NowUs();
+    uint64_t TimeAtPos(uint64_t pos) const { return capture_ring_.TimeAtPos(pos); }
+    uint64_t PosAtTime(uint64_t time_us) const { return capture_ring_.PosAtTime(time_us); }
+    // 已经写进环形缓冲区的录音位置 (下一个样本的序号)
+    uint64_t CapturePos() const { return capture_ring_.WritePos(); }
+    // start_time_us 为 0 表示从现在开始；否则从缓冲区历史中的该时刻开始保存
+    void SaveStart(const std::string& filename, uint64_t start_time_us = 0);
     void SaveStop();
+    const WavWriter& Recorder() const { return wav_writer_; }
+
+    // 内存录音：和 SaveStart/SaveStop 一样从录音游标取数据，但存进预分配的内存，不落盘
+    // 两种录音共用一个游标，同一时间只能有一种在进行，开始一种会停掉另一种
+    void UtteranceStart(uint64_t start_time_us = 0);
+    // 停止并回填 WAV 头；返回的缓冲区在下一次 UtteranceStart 之前保持有效
+    const UtteranceBuffer& UtteranceStop();
+    const UtteranceBuffer& Utterance() const { return utterance_; }
+    // 录音中跳过一段 (本机播放的提示音会被麦克风录进去)：录到 pos 为止先停下，
+    // Resume 时从 pos 接着录，中间的音频不进文件/内存录音；下一次开始录音时自动取消
+    void RecordHold(uint64_t pos);
+    void RecordResume(uint64_t pos);
 
     // 播放接口
     void PutFrame(const std::vector<int16_t>& pcm_frame);
     void PlayWavFile(const std::string& filename);
+
+    // 流式播放 (边下载边播)：喂入任意切分的 WAV 字节流，解析出的 PCM 按周期切块进入播放队列
+    // 队列攒够 prefill_ms 的数据 (或 PlayStreamEnd) 之前播放线程先不出声，吸收网络抖动
+    void PlayStreamBegin(unsigned int prefill_ms);
+    // 返回 false 表示数据不是可播放的 WAV (16bit 单/双声道)
+    bool PlayStreamWrite(const void* wav_bytes, size_t size);
+    // 下一段独立的 WAV (按句流水线的下一句) 开始：重置解析器，播放队列不动，
+    // 上一句还在播的时候下一句就接在队尾，不满一个周期的尾巴和下一句拼在一起，句间没有空隙
+    void PlayStreamNextClip();
+    // 数据结束：补齐最后一个周期并放开预缓冲
+    void PlayStreamEnd();
+    // 本次流式播放是否已经解析出了音频
+    bool PlayStreamHasAudio() const { return play_stream_samples_.load() > 0; }
+    // 给网络回调用的适配函数 (在网络线程里调用)，self 是 AudioProcess*
+    static bool PlayStreamSink(const void* wav_bytes, size_t size, void* self);
+    static void PlayStreamFinish(void* self);
+    static void PlayStreamClip(void* self);
     
     // [修改] 查询播放状态 (改为检查队列是否为空)
     bool IsPlaying(); 
+    // 硬件播放缓冲区的大小 (单声道样本)：IsPlaying() 变成 false 之后最多还有这么多样本没从喇叭出来
+    size_t PlaybackBufferSize() const { return play_buffer_.load(); }
 
     // [新增] 计算 RMS 能量 (静态工具函数)
     static double CalculateRMS(const std::vector<int16_t>& data);
@@ -52,25 +148,90 @@ private:
     void RecordLoop();
     void PlayLoop();
 
+    // 录音设备：打开 (mmap 失败时退回读写模式) / 读一个周期进环形缓冲区 / 出错后恢复
+    // CaptureOnce 返回写入的样本数，出错返回负的错误码；stereo/mono 只有读写模式用到
+    bool OpenCapture(bool mmap);
+    void CloseCapture();
+    int CaptureOnce(std::vector<int16_t>& stereo, std::vector<int16_t>& mono);
+    int CaptureMmapOnce();
+    void RecoverCapture();
+    // 播放设备：同上；PlaybackWrite 写完 n 个单声道样本才返回 (缓冲区满时等待)，
+    // stereo 是读写模式的转换缓存；last 表示后面暂时没有数据了 (mmap 模式下缓冲区没填满也要开始播)
+    bool OpenPlayback(bool mmap);
+    void ClosePlayback();
+    int PlaybackWrite(const int16_t* mono, size_t n, std::vector<int16_t>& stereo, bool last);
+    int PlaybackMmapWrite(const int16_t* mono, size_t n, bool last);
+    void RecoverPlayback();
+    // 当前线程已经用掉的 CPU 时间 (用户态 + 内核态，微秒)
+    static uint64_t ThreadCpuUs();
+
+    // 按当前档位依次尝试候选的周期配置，打开成功后 config 是协商后的结果，并打印实际延迟；全部失败返回 nullptr
+    struct pcm* OpenPcm(unsigned int flags, struct pcm_config& config);
+
     // 状态控制
     std::atomic<bool> is_running_{false};
 
     // 录音相关
     std::thread record_thread_;
-    std::mutex record_mutex_;
-    std::queue<std::vector<int16_t>> recorded_queue_;
-    struct pcm_config config_;
+    CaptureRing capture_ring_;
+    MicArray mic_array_;
+    std::mutex taps_mutex_;
+    CaptureTap taps_[MAX_CAPTURE_TAPS];
+    std::mutex capture_mutex_;              // 只配合 capture_cv_ 使用，环形缓冲区本身无锁
+    std::condition_variable capture_cv_;    // 每写入一个周期通知一次 (WaitCapture)
+    VadEngine vad_;                         // 只有录音线程写
+    Profile profile_;
+    struct pcm_config capture_config_;      // 只由录音线程使用
+    std::atomic<size_t> capture_period_{0}; // 协商后的录音周期 (给其他线程读)
     struct pcm* pcm_in_ = nullptr;
+    bool use_mmap_;                         // 打开设备时是否先尝试 mmap
+    std::atomic<bool> capture_mmap_{false}; // 录音设备实际的模式
+    std::atomic<uint64_t> capture_cpu_us_{0};   // 录音线程的 CPU 时间和录到的样本数 (LogIoStats)
+    std::atomic<uint64_t> capture_samples_{0};
     
-    // 文件录制
-    std::mutex file_mutex_;
-    FILE* record_fp_ = nullptr;
+    // 文件/内存录制 (也是一个订阅者)：录音线程把游标上的新数据 memcpy 给当前的去处，
+    // 文件的 write()/fsync 在 WavWriter 自己的线程里做
+    enum RecordSink {
+        kSinkNone = 0,
+        kSinkFile = 1,    // WavWriter
+        kSinkMemory = 2,  // UtteranceBuffer
+    };
+    void DrainRecorder();
+    void StartRecorder(RecordSink sink, uint64_t start_time_us);
+    void StopRecorder();
+    std::mutex file_mutex_;            // 只在控制线程之间互斥 SaveStart/SaveStop/UtteranceStart/UtteranceStop
+    WavWriter wav_writer_;
+    UtteranceBuffer utterance_;
+    CaptureTap* record_tap_ = nullptr;
+    std::atomic<int> record_sink_{kSinkNone};  // 录音线程把数据送到哪里
+    std::atomic<bool> record_busy_{false};     // 录音线程正在读 record_tap_
+    std::atomic<uint64_t> record_hold_pos_{UINT64_MAX};  // 录到这里先停下 (RecordHold)，UINT64_MAX 表示不停
+    std::atomic<uint64_t> record_resume_pos_{0};         // 录音线程下次从这里接着录 (RecordResume)，0 表示没有
 
     // 播放相关
     std::thread play_thread_;
     std::mutex playback_mutex_;
     std::condition_variable playback_cv_;
     std::queue<std::vector<int16_t>> playback_queue_;
+    struct pcm_config playback_config_;     // 只由播放线程使用
+    std::atomic<size_t> play_period_{0};    // 协商后的播放周期：播放队列按它切块
+    std::atomic<size_t> play_buffer_{0};    // 协商后的硬件缓冲区 (周期 x 周期数)
+    std::atomic<bool> playback_mmap_{false};
+    bool playback_started_ = false;         // mmap 播放：已经 pcm_start (读写模式由 pcm_write 自己启动)
+    std::atomic<uint64_t> play_cpu_us_{0};
+    std::atomic<uint64_t> play_samples_{0};
+
+    // 流式播放 (解析器和 play_pcm_ 只由调用 PlayStream* 的线程访问；
+    // PlayStreamBegin 可以在另一个线程调用，只要在第一次 PlayStreamWrite 之前)
+    void QueueStreamFrames(bool flush);
+    WavStreamParser play_parser_;
+    std::vector<int16_t> play_pcm_;        // 还不够一个周期的样本
+    std::atomic<size_t> play_stream_samples_{0};   // 其他线程用它判断回复开始出声了没有
+    size_t play_prefill_frames_ = 0;
+    bool play_stream_open_ = false;        // playback_mutex_ 保护：流还没结束
+    bool play_gate_ = false;               // playback_mutex_ 保护：预缓冲中，播放线程暂不取数据
+    unsigned int play_clips_ = 0;          // 本次流式播放的段数
+    unsigned int play_underruns_ = 0;      // playback_mutex_ 保护：流还没结束队列就空了 (下一句没赶上)
     struct pcm* pcm_out_ = nullptr;
 };
 
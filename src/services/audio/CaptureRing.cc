@@ -0,0 +1,257 @@
+#include "CaptureRing.h"
+#include <algorithm>
+#include <cstring>
+
+// ==========================================
+// CaptureRing (单写者)
+// ==========================================
+
+CaptureRing::CaptureRing(size_t min_capacity, unsigned int sample_rate) : rate_(sample_rate) {
+    size_t cap = 1;
+    while (cap < min_capacity) cap <<= 1;
+    buffer_.assign(cap, 0);
+    mask_ = cap - 1;
+}
+
+void CaptureRing::Write(const int16_t* data, size_t n, uint64_t end_time_us) {
+    // 超过容量的部分写了也会被自己覆盖，只保留最后 Capacity() 个
+    if (n > Capacity()) {
+        // 跳过的那段直接算作已被覆盖 (先声明整个区间，再移动写位置)
+        uint64_t w = write_.load(std::memory_order_relaxed);
+        uint64_t skip = n - Capacity();
+        claim_.store(w + n, std::memory_order_release);
+        write_.store(w + skip, std::memory_order_release);
+        data += skip;
+        n = Capacity();
+    }
+
+    int16_t* part[2];
+    size_t len[2];
+    BeginWrite(n, part, len);
+    memcpy(part[0], data, len[0] * sizeof(int16_t));
+    if (len[1]) memcpy(part[1], data + len[0], len[1] * sizeof(int16_t));
+    CommitWrite(n, end_time_us);
+}
+
+uint64_t CaptureRing::BeginWrite(size_t n, int16_t* part[2], size_t len[2]) {
+    uint64_t w = write_.load(std::memory_order_relaxed);
+
+    // 1. 先声明即将覆盖的区间，读者据此判断拷贝结果是否有效
+    claim_.store(w + n, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // 2. 交出要写的区间 (处理回绕)
+    size_t idx = (size_t)(w & mask_);
+    size_t first = std::min(n, Capacity() - idx);
+    part[0] = &buffer_[idx];
+    len[0] = first;
+    part[1] = n > first ? &buffer_[0] : nullptr;
+    len[1] = n - first;
+    return w;
+}
+
+void CaptureRing::CommitWrite(size_t n, uint64_t end_time_us) {
+    uint64_t w = write_.load(std::memory_order_relaxed);
+
+    // 3. 记录时间锚点，再发布数据
+    //    锚点槽位要再过 CAPTURE_TIME_ANCHORS 个周期才会被复用，读者看到的都是完整的
+    uint32_t count = anchor_count_.load(std::memory_order_relaxed);
+    Anchor& anchor = anchors_[count % CAPTURE_TIME_ANCHORS];
+    anchor.pos.store(w + n, std::memory_order_relaxed);
+    anchor.time_us.store(end_time_us, std::memory_order_relaxed);
+    anchor_count_.store(count + 1, std::memory_order_release);
+
+    write_.store(w + n, std::memory_order_release);
+}
+
+uint64_t CaptureRing::OldestPos() const {
+    uint64_t claim = claim_.load(std::memory_order_acquire);
+    return claim > Capacity() ? claim - Capacity() : 0;
+}
+
+bool CaptureRing::CopyAt(uint64_t pos, int16_t* out, size_t n) const {
+    if (n > Capacity()) return false;
+    if (pos + n > WritePos()) return false;   // 还没写到
+    if (pos < OldestPos()) return false;      // 已经被覆盖
+
+    size_t idx = (size_t)(pos & mask_);
+    size_t first = std::min(n, Capacity() - idx);
+    memcpy(out, &buffer_[idx], first * sizeof(int16_t));
+    if (n > first) memcpy(out + first, &buffer_[0], (n - first) * sizeof(int16_t));
+
+    // 拷贝期间写者可能已经套圈，再校验一次
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return pos >= OldestPos();
+}
+
+bool CaptureRing::ViewAt(uint64_t pos, size_t n, CaptureView& view) const {
+    if (n > Capacity()) return false;
+    if (pos + n > WritePos()) return false;   // 还没写到
+    if (pos < OldestPos()) return false;      // 已经被覆盖
+
+    size_t idx = (size_t)(pos & mask_);
+    size_t first = std::min(n, Capacity() - idx);
+    view.part[0] = &buffer_[idx];
+    view.len[0] = first;
+    view.part[1] = n > first ? &buffer_[0] : nullptr;
+    view.len[1] = n - first;
+    view.pos = pos;
+    return true;
+}
+
+bool CaptureRing::Intact(const CaptureView& view) const {
+    // 同 CopyAt：读完数据之后再看写者有没有套圈
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return view.pos >= OldestPos();
+}
+
+const int16_t* CaptureView::Data(int16_t* scratch) const {
+    if (Contiguous()) return part[0];
+    memcpy(scratch, part[0], len[0] * sizeof(int16_t));
+    memcpy(scratch + len[0], part[1], len[1] * sizeof(int16_t));
+    return scratch;
+}
+
+const CaptureRing::Anchor& CaptureRing::AnchorFor(uint64_t pos) const {
+    uint32_t count = anchor_count_.load(std::memory_order_acquire);
+    uint32_t newest = (count - 1) % CAPTURE_TIME_ANCHORS;
+    uint32_t usable = std::min<uint32_t>(count, CAPTURE_TIME_ANCHORS - 1);
+
+    // 从最新往回找，停在覆盖 pos 的最早一个锚点 (XRUN 造成的时间断档不会跨锚点传播)
+    const Anchor* best = &anchors_[newest];
+    for (uint32_t i = 1; i < usable; ++i) {
+        const Anchor& a = anchors_[(count - 1 - i) % CAPTURE_TIME_ANCHORS];
+        if (a.pos.load(std::memory_order_relaxed) < pos) break;
+        best = &a;
+    }
+    return *best;
+}
+
+uint64_t CaptureRing::TimeAtPos(uint64_t pos) const {
+    if (anchor_count_.load(std::memory_order_acquire) == 0) return 0;
+
+    const Anchor& a = AnchorFor(pos);
+    uint64_t a_pos = a.pos.load(std::memory_order_relaxed);
+    uint64_t a_time = a.time_us.load(std::memory_order_relaxed);
+    if (pos >= a_pos) return a_time + (pos - a_pos) * 1000000ULL / rate_;
+
+    uint64_t back_us = (a_pos - pos) * 1000000ULL / rate_;
+    return a_time > back_us ? a_time - back_us : 0;
+}
+
+uint64_t CaptureRing::PosAtTime(uint64_t time_us) const {
+    uint32_t count = anchor_count_.load(std::memory_order_acquire);
+    if (count == 0) return WritePos();
+
+    // 找到时间不早于 time_us 的最早锚点，从它往回换算
+    uint32_t usable = std::min<uint32_t>(count, CAPTURE_TIME_ANCHORS - 1);
+    const Anchor* best = &anchors_[(count - 1) % CAPTURE_TIME_ANCHORS];
+    for (uint32_t i = 1; i < usable; ++i) {
+        const Anchor& a = anchors_[(count - 1 - i) % CAPTURE_TIME_ANCHORS];
+        if (a.time_us.load(std::memory_order_relaxed) < time_us) break;
+        best = &a;
+    }
+
+    uint64_t a_pos = best->pos.load(std::memory_order_relaxed);
+    uint64_t a_time = best->time_us.load(std::memory_order_relaxed);
+    uint64_t pos;
+    if (time_us >= a_time) {
+        pos = a_pos + (time_us - a_time) * rate_ / 1000000ULL;
+    } else {
+        uint64_t back = (a_time - time_us) * rate_ / 1000000ULL;
+        pos = a_pos > back ? a_pos - back : 0;
+    }
+    return std::max(OldestPos(), std::min(pos, WritePos()));
+}
+
+// ==========================================
+// CaptureTap (每个消费者一个)
+// ==========================================
+
+void CaptureTap::Attach(const CaptureRing* ring, const std::string& name, size_t hop) {
+    ring_ = ring;
+    name_ = name;
+    hop_ = hop;
+    pos_.store(ring->WritePos(), std::memory_order_relaxed);
+    max_lag_.store(0, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+    overruns_.store(0, std::memory_order_relaxed);
+}
+
+bool CaptureTap::Read(int16_t* out, size_t n) {
+    if (!ring_) return false;
+
+    size_t lag = Lag();
+    if (lag > max_lag_.load(std::memory_order_relaxed)) {
+        max_lag_.store(lag, std::memory_order_relaxed);
+    }
+    if (lag < n) return false;
+
+    uint64_t pos = pos_.load(std::memory_order_relaxed);
+    if (!ring_->CopyAt(pos, out, n)) {
+        SkipOverrun();
+        return false;
+    }
+    pos_.store(pos + n, std::memory_order_relaxed);
+    return true;
+}
+
+bool CaptureTap::Peek(size_t n, CaptureView& view) {
+    if (!ring_ || n == 0) return false;
+
+    size_t lag = Lag();
+    if (lag > max_lag_.load(std::memory_order_relaxed)) {
+        max_lag_.store(lag, std::memory_order_relaxed);
+    }
+    if (lag < n) return false;
+
+    if (!ring_->ViewAt(pos_.load(std::memory_order_relaxed), n, view)) {
+        SkipOverrun();
+        return false;
+    }
+    return true;
+}
+
+bool CaptureTap::Consume(const CaptureView& view) {
+    if (!ring_) return false;
+    if (!ring_->Intact(view)) {
+        SkipOverrun();
+        return false;
+    }
+    pos_.store(view.EndPos(), std::memory_order_relaxed);
+    return true;
+}
+
+void CaptureTap::Clear() {
+    if (!ring_) return;
+    pos_.store(ring_->WritePos(), std::memory_order_relaxed);
+}
+
+void CaptureTap::Seek(uint64_t pos) {
+    if (!ring_) return;
+    pos = std::max(pos, ring_->OldestPos());
+    pos_.store(std::min(pos, ring_->WritePos()), std::memory_order_relaxed);
+}
+
+void CaptureTap::SeekToTime(uint64_t time_us) {
+    if (!ring_) return;
+    Seek(ring_->PosAtTime(time_us));
+}
+
+size_t CaptureTap::Lag() const {
+    if (!ring_) return 0;
+    uint64_t w = ring_->WritePos();
+    uint64_t pos = pos_.load(std::memory_order_relaxed);
+    return w > pos ? (size_t)(w - pos) : 0;
+}
+
+void CaptureTap::SkipOverrun() {
+    // 跳到最旧位置之后再留 1/4 容量的余量，避免下一个周期又被套圈
+    uint64_t pos = pos_.load(std::memory_order_relaxed);
+    uint64_t target = std::min(ring_->OldestPos() + ring_->Capacity() / 4, ring_->WritePos());
+    if (target <= pos) return;
+
+    dropped_.fetch_add(target - pos, std::memory_order_relaxed);
+    overruns_.fetch_add(1, std::memory_order_relaxed);
+    pos_.store(target, std::memory_order_relaxed);
+}
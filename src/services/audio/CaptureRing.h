@@ -0,0 +1,156 @@
+/**
+ * @file CaptureRing.h
+ * @brief 录音广播环形缓冲区 + 独立读游标 (Capture Fan-out)
+ *
+ * 录音线程是唯一的写者，样本只存一份；每个消费者 (唤醒、VAD、录音文件、电平表...)
+ * 通过 AudioProcess::Subscribe() 拿到自己的 CaptureTap，各自前进、互不干扰。
+ *
+ * 设计要点:
+ * 1. 写者永不阻塞，也不关心读者：最旧的数据直接被覆盖。
+ * 2. 位置使用 64 位单调递增的绝对样本序号，落后太多的读者在读取时自行发现并跳过，
+ *    丢弃的样本数记入该游标自己的统计。
+ * 3. 写者先发布 "claim" 再拷贝数据，读者拷贝后再校验 claim (seqlock 思路)，
+ *    从而识别拷贝过程中被覆盖的区间。
+ * 4. 每次写入附带一个时间锚点 (样本序号 <-> CLOCK_MONOTONIC 微秒)，
+ *    缓冲区中的历史数据因此可以按时间定位 (唤醒前后的 pre-roll)。
+ * 5. 读取粒度和 ALSA 周期无关：每个游标有自己的跳长 (hop)，Peek() 直接给出环形缓冲区里的视图 (不拷贝)，
+ *    用完 Consume() 再校验一次 (同 3)。VAD 按 10ms、唤醒按 Snowboy 的块长，录音周期怎么设都不影响它们。
+ */
+
+#ifndef CAPTURE_RING_H
+#define CAPTURE_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 时间锚点个数：每个 ALSA 周期一个，需覆盖整个缓冲区的时长 (低延迟档 10ms 周期下约 5 秒)
+#define CAPTURE_TIME_ANCHORS 512
+
+// 环形缓冲区里一段样本的只读视图 (零拷贝)：回绕处分成两段
+// 指向的是环形缓冲区本身，写者套圈后内容会被覆盖，用完要交给 CaptureTap::Consume() 校验
+struct CaptureView {
+    const int16_t* part[2] = {nullptr, nullptr};
+    size_t len[2] = {0, 0};
+    uint64_t pos = 0;   // 第一个样本的录音位置
+
+    size_t Size() const { return len[0] + len[1]; }
+    uint64_t EndPos() const { return pos + Size(); }
+    bool Contiguous() const { return len[1] == 0; }
+    // 给需要连续内存的消费者 (Snowboy)：不回绕时直接返回缓冲区里的指针，回绕时拼到 scratch (至少 Size() 个样本)
+    const int16_t* Data(int16_t* scratch) const;
+};
+
+class CaptureRing {
+public:
+    CaptureRing(size_t min_capacity, unsigned int sample_rate);
+
+    CaptureRing(const CaptureRing&) = delete;
+    void operator=(const CaptureRing&) = delete;
+
+    size_t Capacity() const { return buffer_.size(); }
+
+    // [录音线程] 追加样本，覆盖最旧的数据
+    // end_time_us: 最后一个样本的采集时间 (CLOCK_MONOTONIC, 微秒)
+    void Write(const int16_t* data, size_t n, uint64_t end_time_us);
+    // [录音线程] 原地写入 (mmap 录音直接把 DMA 缓冲区合成到这里，不经过中间缓存)：
+    // BeginWrite 声明接下来的 n 个样本 (n <= Capacity()) 并给出要填的区间 (回绕处分成两段)，返回它的起始位置；
+    // 填完后 CommitWrite 发布。两次调用之间不能有别的写入
+    uint64_t BeginWrite(size_t n, int16_t* part[2], size_t len[2]);
+    void CommitWrite(size_t n, uint64_t end_time_us);
+
+    // 已发布 (可读) 数据的结束位置
+    uint64_t WritePos() const { return write_.load(std::memory_order_acquire); }
+
+    // 当前仍然安全可读的最旧位置
+    uint64_t OldestPos() const;
+
+    // 拷贝 [pos, pos + n) 到 out；区间未写完或已被覆盖时返回 false
+    bool CopyAt(uint64_t pos, int16_t* out, size_t n) const;
+    // [pos, pos + n) 的零拷贝视图；区间未写完或已被覆盖时返回 false
+    bool ViewAt(uint64_t pos, size_t n, CaptureView& view) const;
+    // 视图从取出到现在有没有被写者覆盖 (用完之后调用)
+    bool Intact(const CaptureView& view) const;
+
+    // --- 时间索引 ---
+    // 样本位置对应的采集时间；没有任何数据时返回 0
+    uint64_t TimeAtPos(uint64_t pos) const;
+    // 时间对应的样本位置，结果限制在 [OldestPos(), WritePos()] 内
+    uint64_t PosAtTime(uint64_t time_us) const;
+
+private:
+    struct Anchor {
+        std::atomic<uint64_t> pos{0};      // 该次写入结束时的样本位置
+        std::atomic<uint64_t> time_us{0};  // 对应的采集时间
+    };
+
+    // 找到 pos 之后最近的锚点 (没有则用最新的)，按采样率线性换算
+    const Anchor& AnchorFor(uint64_t pos) const;
+
+    std::vector<int16_t> buffer_;
+    size_t mask_ = 0;
+    unsigned int rate_;
+    Anchor anchors_[CAPTURE_TIME_ANCHORS];
+    std::atomic<uint32_t> anchor_count_{0};
+    std::atomic<uint64_t> claim_{0};  // 写者正在写入区间的结束位置
+    std::atomic<uint64_t> write_{0};  // 已完成写入的结束位置
+};
+
+// 单个消费者的读游标，只允许其拥有者线程调用读取接口
+class CaptureTap {
+public:
+    CaptureTap() = default;
+
+    CaptureTap(const CaptureTap&) = delete;
+    void operator=(const CaptureTap&) = delete;
+
+    // 读取恰好 n 个样本，数据不足时返回 false 且不前进
+    bool Read(int16_t* out, size_t n);
+    bool Read(std::vector<int16_t>& out) { return Read(out.data(), out.size()); }
+
+    // 零拷贝读取：接下来 n 个样本 (默认一个 hop) 的视图，不前进；数据不足时返回 false
+    bool Peek(CaptureView& view) { return Peek(hop_, view); }
+    bool Peek(size_t n, CaptureView& view);
+    // 用完视图后前进到它的末尾；返回 false 表示使用期间被写者覆盖 (结果要丢弃)，游标已跳过丢失的部分
+    bool Consume(const CaptureView& view);
+    // 跳长：Peek() 默认每次取多少样本 (Subscribe 时指定)
+    size_t Hop() const { return hop_; }
+
+    // 丢弃未读数据，游标跳到最新位置 (只影响自己)
+    void Clear();
+
+    // 回到历史中的某个位置/时间 (pre-roll)，超出保留范围时停在最旧的数据
+    void Seek(uint64_t pos);
+    void SeekToTime(uint64_t time_us);
+
+    const std::string& Name() const { return name_; }
+    uint64_t Position() const { return pos_.load(std::memory_order_relaxed); }
+
+    // --- 统计信息 (可从其他线程读取) ---
+    size_t Lag() const;                                   // 当前未读样本数
+    size_t MaxLag() const { return max_lag_.load(std::memory_order_relaxed); }
+    uint64_t DroppedSamples() const { return dropped_.load(std::memory_order_relaxed); }
+    uint32_t OverrunCount() const { return overruns_.load(std::memory_order_relaxed); }
+
+private:
+    friend class AudioProcess;
+
+    void Attach(const CaptureRing* ring, const std::string& name, size_t hop);
+    void Detach() { ring_ = nullptr; }
+    bool InUse() const { return ring_ != nullptr; }
+
+    // 被写者套圈后跳到最旧的安全位置，并记录丢失
+    void SkipOverrun();
+
+    const CaptureRing* ring_ = nullptr;
+    std::string name_;
+    size_t hop_ = 0;
+    std::atomic<uint64_t> pos_{0};
+    std::atomic<size_t> max_lag_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint32_t> overruns_{0};
+};
+
+#endif // CAPTURE_RING_H
@@ -0,0 +1,93 @@
+#include "Endpointer.h"
+#include "common/config.h"
+#include <algorithm>
+
+#if ENDPOINT_LONG_MS <= ENDPOINT_SHORT_MS
+#error "ENDPOINT_LONG_MS must be greater than ENDPOINT_SHORT_MS"
+#endif
+
+Endpointer::Endpointer(unsigned int sample_rate) : rate_(sample_rate) {
+    Reset();
+}
+
+void Endpointer::Reset() {
+    total_ = 0;
+    started_ = false;
+    voiced_run_ = 0;
+    speech_start_pos_ = 0;
+    speech_end_pos_ = 0;
+    pause_ = 0;
+    silence_x2_ = 0;
+    pauses_ = 0;
+    max_pause_ = 0;
+    prob_sum_ = 0;
+    prob_frames_ = 0;
+    hangover_ = Samples(ENDPOINT_MIN_HANGOVER_MS);
+}
+
+size_t Endpointer::ComputeHangover() const {
+    const size_t min_h = Samples(ENDPOINT_MIN_HANGOVER_MS);
+    const size_t max_h = Samples(ENDPOINT_MAX_HANGOVER_MS);
+    const size_t short_len = Samples(ENDPOINT_SHORT_MS);
+    const size_t long_len = Samples(ENDPOINT_LONG_MS);
+
+    // 1. 长度：SHORT 以下取最小值，LONG 以上取最大值，中间线性
+    size_t len = (size_t)(speech_end_pos_ - speech_start_pos_);
+    size_t ramp = len > short_len ? std::min(len, long_len) - short_len : 0;
+    size_t h = min_h + (size_t)((uint64_t)(max_h - min_h) * ramp / (long_len - short_len));
+
+    // 2. 停顿：结尾至少比句中最长的停顿再长 1/4
+    if (pauses_ > 0) h = std::max(h, max_pause_ + max_pause_ / 4);
+
+    // 3. 置信度：语音段平均概率不到 ON 和满分的中点，多等 1/4
+    if (prob_frames_ > 0 && prob_sum_ / prob_frames_ < (uint64_t)(VAD_SPEECH_ON + 255) / 2) h += h / 4;
+
+    return std::min(h, max_h);
+}
+
+Endpointer::Decision Endpointer::Feed(const VadResult& vad, size_t n, uint64_t end_pos) {
+    total_ += n;
+
+    if (vad.speech) {
+        if (!started_) {
+            voiced_run_ += n;
+            if (voiced_run_ >= Samples(ENDPOINT_MIN_SPEECH_MS)) {
+                started_ = true;
+                speech_start_pos_ = end_pos - voiced_run_;
+            }
+        } else if (pause_ >= Samples(ENDPOINT_PAUSE_MIN_MS)) {
+            // 停顿之后又开口了，记一次句中停顿
+            pauses_++;
+            max_pause_ = std::max(max_pause_, pause_);
+        }
+        if (started_) {
+            speech_end_pos_ = end_pos;
+            prob_sum_ += vad.prob;
+            prob_frames_++;
+        }
+        pause_ = 0;
+        silence_x2_ = 0;
+    } else if (!started_) {
+        voiced_run_ = 0;
+    } else {
+        pause_ += n;
+        // 概率已经掉到 OFF 的一半以下才算确定的静音，否则只算半帧
+        silence_x2_ += vad.prob < VAD_SPEECH_OFF / 2 ? 2 * n : n;
+        hangover_ = ComputeHangover();
+        if (silence_x2_ >= 2 * hangover_) return kEndOfSpeech;
+    }
+
+    if (!started_ && total_ >= Samples(ENDPOINT_NO_SPEECH_MS)) return kNoSpeech;
+    if (total_ >= Samples(ENDPOINT_MAX_RECORD_MS)) return kTimeout;
+    return kContinue;
+}
+
+const char* Endpointer::DecisionName(Decision d) {
+    switch (d) {
+        case kContinue:    return "continue";
+        case kEndOfSpeech: return "end of speech";
+        case kNoSpeech:    return "no speech";
+        case kTimeout:     return "timeout";
+    }
+    return "?";
+}
@@ -0,0 +1,72 @@
+/**
+ * @file Endpointer.h
+ * @brief 说完判定 (endpointing)：结尾静音的等待时长随这一句话自适应
+ *
+ * 原来固定等 2 秒静音，每轮对话都白白多出 2 秒才开始上传。这里按 VAD 帧 (10ms) 逐帧判定，
+ * 需要等多久的静音 (hangover) 由这一句话本身决定:
+ * 1. 长度：短指令 (不到 ENDPOINT_SHORT_MS) 只等 ENDPOINT_MIN_HANGOVER_MS，
+ *    越长等得越久，到 ENDPOINT_LONG_MS 以上等 ENDPOINT_MAX_HANGOVER_MS (口述长句中间会停下来想)。
+ * 2. 停顿：句中出现过停顿时，结尾至少要比最长的那次停顿再长 1/4 (这个人说话就是会停这么久)。
+ * 3. 置信度：语音段的平均概率偏低 (远场、小声) 时多等 1/4；
+ *    静音期间概率还不够低 (VAD 拿不准) 的帧只按半帧计入静音。
+ * 开始说话要求连续 ENDPOINT_MIN_SPEECH_MS 的语音帧，单个咔哒声不会让判定开始。
+ *
+ * 位置都是录音位置 (CaptureRing 的绝对样本序号)，说完的时刻可以换算到录音时间轴上统计延迟。
+ */
+
+#ifndef ENDPOINTER_H
+#define ENDPOINTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "VadEngine.h"
+
+class Endpointer {
+public:
+    enum Decision {
+        kContinue = 0,   // 继续录
+        kEndOfSpeech,    // 说完了
+        kNoSpeech,       // 一直没开口
+        kTimeout,        // 录太久了
+    };
+
+    explicit Endpointer(unsigned int sample_rate = 16000);
+
+    void Reset();
+
+    // 输入一帧的 VAD 结果：这一帧有 n 个样本，结束于录音位置 end_pos
+    Decision Feed(const VadResult& vad, size_t n, uint64_t end_pos);
+
+    bool SpeechStarted() const { return started_; }
+    // 最后一个语音帧的结束位置 (没开口时为 0)
+    uint64_t SpeechEndPos() const { return speech_end_pos_; }
+    // 本句的统计 (日志用)
+    unsigned int HangoverMs() const { return ToMs(hangover_); }
+    unsigned int SpeechMs() const { return ToMs(speech_end_pos_ - speech_start_pos_); }
+    unsigned int Pauses() const { return pauses_; }
+    unsigned int MaxPauseMs() const { return ToMs(max_pause_); }
+
+    static const char* DecisionName(Decision d);
+
+private:
+    size_t Samples(unsigned int ms) const { return (size_t)rate_ * ms / 1000; }
+    unsigned int ToMs(uint64_t samples) const { return (unsigned int)(samples * 1000 / rate_); }
+    size_t ComputeHangover() const;
+
+    unsigned int rate_;
+    uint64_t total_;            // 已经输入的样本数
+    bool started_;
+    size_t voiced_run_;         // 开口之前：连续语音帧的长度
+    uint64_t speech_start_pos_;
+    uint64_t speech_end_pos_;
+    size_t pause_;              // 当前这段静音的长度
+    size_t silence_x2_;         // 计入判定的静音长度 (x2，拿不准的帧只加一倍)
+    unsigned int pauses_;       // 句中停顿的次数 (>= ENDPOINT_PAUSE_MIN_MS，之后又开口了)
+    size_t max_pause_;
+    uint64_t prob_sum_;         // 语音帧的概率之和 (平均置信度)
+    uint32_t prob_frames_;
+    size_t hangover_;           // 最近一次算出的结尾等待 (样本)
+};
+
+#endif // ENDPOINTER_H
@@ -0,0 +1,75 @@
+/**
+ * @file ImaAdpcm.h
+ * @brief IMA-ADPCM 的逐样本编解码 (纯整数运算)
+ *
+ * 上传编码 (AudioEncoder) 和回复音频解码 (WavStreamParser, WAV 格式 0x11) 共用:
+ * 1. 状态只有预测值和步长索引两个整数，每个样本 4bit。
+ * 2. 编码端按解码端能还原出来的值更新预测，两边的状态始终一致。
+ * 3. 不分配内存、不查浮点，可以直接在网络线程/录音线程里逐字节调用。
+ */
+
+#ifndef IMA_ADPCM_H
+#define IMA_ADPCM_H
+
+#include <cstdint>
+
+namespace ImaAdpcm {
+
+static const int kStepTable[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int kIndexTable[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+struct State {
+    int predictor = 0;
+    int index = 0;
+};
+
+// 限制到合法范围 (块头里的值来自网络，不能直接信任)
+inline void Clamp(State& s) {
+    if (s.predictor > 32767) s.predictor = 32767;
+    if (s.predictor < -32768) s.predictor = -32768;
+    if (s.index < 0) s.index = 0;
+    if (s.index > 88) s.index = 88;
+}
+
+// 用 4bit 码更新状态，返回还原出的样本
+inline int16_t Decode(State& s, int code) {
+    int step = kStepTable[s.index];
+    int vpdiff = step >> 3;
+    if (code & 4) vpdiff += step;
+    if (code & 2) vpdiff += step >> 1;
+    if (code & 1) vpdiff += step >> 2;
+    s.predictor += (code & 8) ? -vpdiff : vpdiff;
+    s.index += kIndexTable[code & 7];
+    Clamp(s);
+    return (int16_t)s.predictor;
+}
+
+// 编码一个样本，返回 4bit 码 (状态按解码端的结果更新)
+inline int Encode(State& s, int sample) {
+    int step = kStepTable[s.index];
+    int diff = sample - s.predictor;
+    int code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    // 逐位逼近 diff
+    if (diff >= step) { code |= 4; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { code |= 2; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { code |= 1; }
+    Decode(s, code);
+    return code;
+}
+
+} // namespace ImaAdpcm
+
+#endif // IMA_ADPCM_H
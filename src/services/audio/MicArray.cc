@@ -0,0 +1,69 @@
+#include "MicArray.h"
+#include "AudioKernels.h"
+#include <cstring>
+
+// 每个声道保留的历史样本数：最大整数延迟 + 线性插值多用的 1 个
+#define MIC_HISTORY (MIC_MAX_DELAY_SAMPLES + 1)
+
+MicArray::MicArray() : mode_(kAverage), delay_q8_(0), last_frames_(0) {
+}
+
+void MicArray::Configure(size_t max_frames) {
+    left_.assign(MIC_HISTORY + max_frames, 0);
+    right_.assign(MIC_HISTORY + max_frames, 0);
+    last_frames_ = 0;
+}
+
+void MicArray::SetSteeringDelay(int32_t delay_q8) {
+    const int32_t limit = MIC_MAX_DELAY_SAMPLES * 256;
+    if (delay_q8 > limit) delay_q8 = limit;
+    if (delay_q8 < -limit) delay_q8 = -limit;
+    delay_q8_.store(delay_q8);
+}
+
+const char* MicArray::ModeName(Mode mode) {
+    switch (mode) {
+        case kLeft:     return "left";
+        case kAverage:  return "average";
+        case kDelaySum: return "delay-sum";
+    }
+    return "unknown";
+}
+
+void MicArray::Process(const int16_t* stereo, int16_t* mono, size_t frames) {
+    switch (GetMode()) {
+        case kLeft:
+            AudioKernels::Deinterleave(stereo, mono, frames, 0);
+            break;
+        case kAverage:
+            AudioKernels::MixDown(stereo, mono, frames);
+            break;
+        case kDelaySum:
+            // 上一周期的末尾挪到最前面当作历史，本周期的样本接在后面
+            memmove(left_.data(), left_.data() + last_frames_, MIC_HISTORY * sizeof(int16_t));
+            memmove(right_.data(), right_.data() + last_frames_, MIC_HISTORY * sizeof(int16_t));
+            AudioKernels::Deinterleave(stereo, left_.data() + MIC_HISTORY, frames, 0);
+            AudioKernels::Deinterleave(stereo, right_.data() + MIC_HISTORY, frames, 1);
+            last_frames_ = frames;
+            DelayAndSum(mono, frames, delay_q8_.load());
+            break;
+    }
+}
+
+void MicArray::DelayAndSum(int16_t* mono, size_t frames, int32_t delay_q8) {
+    // 先到达的那一路被延迟；另一路原样参与求和
+    const int16_t* lead = delay_q8 >= 0 ? left_.data() : right_.data();
+    const int16_t* lag  = delay_q8 >= 0 ? right_.data() : left_.data();
+    int32_t d = delay_q8 >= 0 ? delay_q8 : -delay_q8;
+    int32_t k = d >> 8;        // 整数部分
+    int32_t f = d & 0xFF;      // 小数部分 (Q8)
+
+    for (size_t i = 0; i < frames; ++i) {
+        size_t p = MIC_HISTORY + i;
+        // lead[p - d] 的线性插值，结果为 Q8
+        int32_t delayed = lead[p - k] * (256 - f) + lead[p - k - 1] * f;
+        int32_t direct  = lag[p] * 256;
+        // (delayed + direct) / 2 再去掉 Q8，四舍五入；两路都不超过 int16 * 256，结果不会溢出
+        mono[i] = (int16_t)((delayed + direct + 256) >> 9);
+    }
+}
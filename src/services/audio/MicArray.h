@@ -0,0 +1,67 @@
+/**
+ * @file MicArray.h
+ * @brief 双麦克风合成 (硬件双声道 -> 软件单声道)
+ *
+ * RV1106 的录音必须开双声道，这里决定怎么把两路麦克风变成一路:
+ * 1. kLeft:     只取左声道 (旧行为，用于对比/排查硬件问题)。
+ * 2. kAverage:  (L + R) / 2，两路噪声不相关时约有 3 dB 的 SNR 提升。
+ * 3. kDelaySum: 固定指向的延迟求和波束，先到达的那一路延迟 steering delay 后再平均，
+ *               目标方向的声音同相叠加，其他方向的声音部分抵消。
+ *
+ * 全部是定点运算 (延迟为 Q8 分数样本，线性插值)，Configure() 之后 Process() 不分配内存。
+ * 模式和延迟可以从任意线程修改，录音线程在下一个周期生效。
+ */
+
+#ifndef MIC_ARRAY_H
+#define MIC_ARRAY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 延迟求和允许的最大延迟 (样本)。16kHz 下 8 个样本约等于 17cm 的声程差，远大于板上麦克风间距
+#define MIC_MAX_DELAY_SAMPLES 8
+
+class MicArray {
+public:
+    enum Mode {
+        kLeft = 0,
+        kAverage = 1,
+        kDelaySum = 2,
+    };
+
+    MicArray();
+
+    MicArray(const MicArray&) = delete;
+    void operator=(const MicArray&) = delete;
+
+    // 按一个周期的最大帧数预分配历史缓冲区，必须在录音线程启动前调用
+    void Configure(size_t max_frames);
+
+    void SetMode(Mode mode) { mode_.store(mode); }
+    Mode GetMode() const { return (Mode)mode_.load(); }
+
+    // 右声道相对左声道的到达延迟，Q8 样本 (256 = 1 个样本)
+    // 正值：声音先到左麦，左声道被延迟对齐；负值反之。超出范围会被截断
+    void SetSteeringDelay(int32_t delay_q8);
+    int32_t GetSteeringDelay() const { return delay_q8_.load(); }
+
+    // [录音线程] 交织双声道 -> 单声道，frames 不能超过 Configure() 的 max_frames
+    void Process(const int16_t* stereo, int16_t* mono, size_t frames);
+
+    static const char* ModeName(Mode mode);
+
+private:
+    void DelayAndSum(int16_t* mono, size_t frames, int32_t delay_q8);
+
+    std::atomic<int> mode_;
+    std::atomic<int32_t> delay_q8_;
+
+    // 每个声道 = 上一周期末尾 MIC_MAX_DELAY_SAMPLES + 1 个样本的历史 + 本周期样本
+    std::vector<int16_t> left_;
+    std::vector<int16_t> right_;
+    size_t last_frames_;
+};
+
+#endif // MIC_ARRAY_H
@@ -0,0 +1,92 @@
+/**
+ * @file RingBuffer.h
+ * @brief 无锁单生产者/单消费者环形缓冲区 (SPSC Ring Buffer)
+ *
+ * 用于录音线程 (生产者) 与主循环 (消费者) 之间传递 PCM 样本:
+ * 1. 容量在构造时一次性分配 (向上取整为 2 的幂)，运行期间零堆分配。
+ * 2. 读写索引各自只由一方修改，通过 acquire/release 原子操作同步，无需互斥锁。
+ * 3. 写入为 "全有或全无"：空间不足时直接返回 0，由调用方统计溢出。
+ */
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t min_capacity) {
+        size_t cap = 1;
+        while (cap < min_capacity) cap <<= 1;
+        buffer_.resize(cap);
+        mask_ = cap - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    void operator=(const SpscRing&) = delete;
+
+    size_t Capacity() const { return buffer_.size(); }
+
+    // [消费者] 当前可读元素个数
+    size_t Available() const {
+        return write_.load(std::memory_order_acquire) - read_.load(std::memory_order_relaxed);
+    }
+
+    // [生产者] 当前可写元素个数
+    size_t Free() const {
+        return Capacity() - (write_.load(std::memory_order_relaxed) - read_.load(std::memory_order_acquire));
+    }
+
+    // [生产者] 写入 n 个元素，空间不足时不写入并返回 0
+    size_t Write(const T* data, size_t n) {
+        if (n == 0 || n > Free()) return 0;
+
+        size_t w = write_.load(std::memory_order_relaxed);
+        CopyIn(w, data, n);
+        write_.store(w + n, std::memory_order_release);
+        return n;
+    }
+
+    // [消费者] 读取 n 个元素到调用方内存，数据不足时不读取并返回 0
+    size_t Read(T* out, size_t n) {
+        if (n == 0 || n > Available()) return 0;
+
+        size_t r = read_.load(std::memory_order_relaxed);
+        CopyOut(r, out, n);
+        read_.store(r + n, std::memory_order_release);
+        return n;
+    }
+
+    // [消费者] 丢弃所有未读数据
+    void Clear() {
+        read_.store(write_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    // 索引单调递增，取模只在访问数组时做，这样 write_ - read_ 永远是有效长度
+    void CopyIn(size_t pos, const T* data, size_t n) {
+        size_t idx = pos & mask_;
+        size_t first = std::min(n, Capacity() - idx);
+        memcpy(&buffer_[idx], data, first * sizeof(T));
+        if (n > first) memcpy(&buffer_[0], data + first, (n - first) * sizeof(T));
+    }
+
+    void CopyOut(size_t pos, T* out, size_t n) const {
+        size_t idx = pos & mask_;
+        size_t first = std::min(n, Capacity() - idx);
+        memcpy(out, &buffer_[idx], first * sizeof(T));
+        if (n > first) memcpy(out + first, &buffer_[0], (n - first) * sizeof(T));
+    }
+
+    std::vector<T> buffer_;
+    size_t mask_ = 0;
+    std::atomic<size_t> write_{0};
+    std::atomic<size_t> read_{0};
+};
+
+#endif // RING_BUFFER_H
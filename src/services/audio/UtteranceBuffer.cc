@@ -0,0 +1,41 @@
+#include "UtteranceBuffer.h"
+#include "WavHeader.h"
+#include <cstring>
+
+UtteranceBuffer::UtteranceBuffer(size_t max_samples, unsigned int sample_rate)
+    : buffer_(WAV_HEADER_SIZE + max_samples * sizeof(int16_t)),
+      max_samples_(max_samples), rate_(sample_rate) {
+    Reset();
+}
+
+void UtteranceBuffer::Reset() {
+    WavHeader dummy_header = MakeWavHeader(rate_, 0);
+    memcpy(buffer_.data(), &dummy_header, sizeof(WavHeader));
+    samples_.store(0, std::memory_order_release);
+    dropped_.store(0, std::memory_order_relaxed);
+}
+
+size_t UtteranceBuffer::Append(const int16_t* data, size_t n) {
+    size_t used = samples_.load(std::memory_order_relaxed);
+    size_t take = n;
+    if (take > max_samples_ - used) take = max_samples_ - used;
+    if (take < n) dropped_.fetch_add(n - take, std::memory_order_relaxed);
+    if (take == 0) return 0;
+
+    memcpy(buffer_.data() + WAV_HEADER_SIZE + used * sizeof(int16_t), data, take * sizeof(int16_t));
+    samples_.store(used + take, std::memory_order_release);
+    return take;
+}
+
+void UtteranceBuffer::Finish() {
+    WavHeader header = MakeWavHeader(rate_, (uint32_t)(Samples() * sizeof(int16_t)));
+    memcpy(buffer_.data(), &header, sizeof(WavHeader));
+}
+
+size_t UtteranceBuffer::WavSize() const {
+    return WAV_HEADER_SIZE + Samples() * sizeof(int16_t);
+}
+
+const int16_t* UtteranceBuffer::Pcm() const {
+    return (const int16_t*)(buffer_.data() + WAV_HEADER_SIZE);
+}
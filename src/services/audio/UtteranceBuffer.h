@@ -0,0 +1,56 @@
+/**
+ * @file UtteranceBuffer.h
+ * @brief 内存中的单句录音 (Utterance Buffer)
+ *
+ * 一轮对话的用户语音直接录进一块预分配的连续内存，不再经过 SD 卡:
+ * 1. 内存布局 = 44 字节 WAV 头 + PCM 样本，Finish() 回填头之后整块就是一个合法的 WAV 文件，
+ *    可以直接交给 NetworkClient::SendAudio 上传；也可以只取后面的裸 PCM。
+ * 2. 容量在构造时一次性分配，录音线程 Append() 只做 memcpy，超出容量的样本丢弃并计数。
+ *
+ * 线程约定: Append() 只由录音线程调用；Reset()/Finish() 和读取接口由控制线程在
+ * 录音线程停止送数据之后调用 (由 AudioProcess 保证)。
+ */
+
+#ifndef UTTERANCE_BUFFER_H
+#define UTTERANCE_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class UtteranceBuffer {
+public:
+    UtteranceBuffer(size_t max_samples, unsigned int sample_rate);
+
+    UtteranceBuffer(const UtteranceBuffer&) = delete;
+    void operator=(const UtteranceBuffer&) = delete;
+
+    // [控制线程] 清空，开始新的一句
+    void Reset();
+    // [录音线程] 追加样本，返回实际保存的个数
+    size_t Append(const int16_t* data, size_t n);
+    // [控制线程] 录音结束，回填 WAV 头
+    void Finish();
+
+    // 整个 WAV 文件 (头 + 数据)
+    const uint8_t* WavData() const { return buffer_.data(); }
+    size_t WavSize() const;
+
+    // 裸 PCM (16bit 单声道)
+    const int16_t* Pcm() const;
+    size_t Samples() const { return samples_.load(std::memory_order_acquire); }
+
+    size_t Capacity() const { return max_samples_; }
+    unsigned int SampleRate() const { return rate_; }
+    uint64_t DroppedSamples() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<uint8_t> buffer_;
+    size_t max_samples_;
+    unsigned int rate_;
+    std::atomic<size_t> samples_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+#endif // UTTERANCE_BUFFER_H
@@ -0,0 +1,151 @@
+#include "VadEngine.h"
+#include "common/config.h"
+#include <algorithm>
+#include <cstring>
+
+// log2 差值 (Q8) -> dB (Q8)：1 个倍频程的能量 = 3.0103 dB，3.0103 * 256 ≈ 771
+#define VAD_LOG2_TO_DB_Q8(x) (((int64_t)(x) * 771) >> 8)
+
+// 整数 log2 (Q8)：最高位的位置 + 其后 8 位作为线性插值的小数部分；v = 0 时返回 0
+static int32_t Log2Q8(uint64_t v) {
+    if (v == 0) return 0;
+    int msb = 63 - __builtin_clzll(v);
+    uint32_t frac = msb >= 8 ? (uint32_t)(v >> (msb - 8)) & 0xFF : (uint32_t)(v << (8 - msb)) & 0xFF;
+    return msb * 256 + (int32_t)frac;
+}
+
+VadEngine::VadEngine(unsigned int sample_rate) : rate_(sample_rate) {
+    for (size_t i = 0; i < VAD_HISTORY; i++) results_[i].store(0, std::memory_order_relaxed);
+    next_index_.store(0, std::memory_order_relaxed);
+    Reset();
+}
+
+void VadEngine::Reset() {
+    primed_ = false;
+    prev_ = 0;
+    pending_count_ = 0;
+    for (Band& b : bands_) {
+        b.floor_q8 = 0;
+        b.last_q8 = 0;
+    }
+    prob_q8_ = 0;
+    speech_ = false;
+}
+
+void VadEngine::Process(const int16_t* pcm, size_t n, uint64_t start_pos) {
+    // 帧按录音位置对齐：pending_ 里的样本从 start_pos - pending_count_ 开始
+    if (pending_count_ > 0) {
+        size_t take = std::min(n, VAD_FRAME_SAMPLES - pending_count_);
+        memcpy(pending_ + pending_count_, pcm, take * sizeof(int16_t));
+        pending_count_ += take;
+        pcm += take;
+        n -= take;
+        start_pos += take;
+        if (pending_count_ < VAD_FRAME_SAMPLES) return;
+        ProcessFrame(pending_, start_pos / VAD_FRAME_SAMPLES - 1);
+        pending_count_ = 0;
+    }
+    // 第一次调用时 start_pos 不一定在帧边界上，先凑齐到边界
+    size_t skip = (size_t)((VAD_FRAME_SAMPLES - start_pos % VAD_FRAME_SAMPLES) % VAD_FRAME_SAMPLES);
+    if (skip > n) skip = n;
+    pcm += skip;
+    n -= skip;
+    start_pos += skip;
+
+    uint64_t index = start_pos / VAD_FRAME_SAMPLES;
+    size_t i = 0;
+    for (; i + VAD_FRAME_SAMPLES <= n; i += VAD_FRAME_SAMPLES) {
+        ProcessFrame(pcm + i, index++);
+    }
+    pending_count_ = n - i;
+    memcpy(pending_, pcm + i, pending_count_ * sizeof(int16_t));
+}
+
+void VadEngine::ProcessFrame(const int16_t* pcm, uint64_t index) {
+    // 1. 两个子带的平均能量：(x[n] + x[n-1]) / 2 偏低频，(x[n] - x[n-1]) / 2 偏高频
+    uint64_t low = 0, high = 0;
+    int32_t prev = prev_;
+    for (size_t i = 0; i < VAD_FRAME_SAMPLES; i++) {
+        int32_t x = pcm[i];
+        int32_t s = (x + prev) >> 1;
+        int32_t d = (x - prev) >> 1;
+        low += (uint32_t)(s * s);
+        high += (uint32_t)(d * d);
+        prev = x;
+    }
+    prev_ = (int16_t)prev;
+    low /= VAD_FRAME_SAMPLES;
+    high /= VAD_FRAME_SAMPLES;
+
+    int32_t level[2] = { Log2Q8(low), Log2Q8(high) };
+    if (!primed_) {
+        bands_[0].floor_q8 = level[0];
+        bands_[1].floor_q8 = level[1];
+        primed_ = true;
+    }
+
+    // 2. 每个子带的信噪比，取较大的一个；噪声底随后更新 (这一帧先按旧的底判断)
+    int32_t snr_q8 = 0;
+    for (int b = 0; b < 2; b++) {
+        Band& band = bands_[b];
+        band.last_q8 = level[b];
+        snr_q8 = std::max(snr_q8, level[b] - band.floor_q8);
+        if (level[b] < band.floor_q8) {
+            band.floor_q8 += (level[b] - band.floor_q8) / 2;
+        } else {
+            band.floor_q8 += std::min<int32_t>(VAD_FLOOR_RISE_Q8, level[b] - band.floor_q8);
+        }
+    }
+    int32_t snr_db_q8 = (int32_t)VAD_LOG2_TO_DB_Q8(snr_q8);
+
+    // 3. 信噪比 -> 概率 (VAD_SNR_LOW_DB 以下为 0，VAD_SNR_HIGH_DB 以上为 255)，太弱的帧直接算 0
+    int32_t raw = (snr_db_q8 - VAD_SNR_LOW_DB * 256) * 255 / ((VAD_SNR_HIGH_DB - VAD_SNR_LOW_DB) * 256);
+    raw = std::max<int32_t>(0, std::min<int32_t>(255, raw));
+    if (low + high < (uint64_t)VAD_MIN_RMS * VAD_MIN_RMS) raw = 0;
+
+    // 快升慢降，一个字里短暂的停顿不会让概率掉下去
+    if (raw > prob_q8_) {
+        prob_q8_ += (raw - prob_q8_ + 1) / 2;
+    } else {
+        prob_q8_ -= (prob_q8_ - raw + 11) / 12;
+    }
+
+    // 4. 迟滞
+    if (!speech_ && prob_q8_ >= VAD_SPEECH_ON) speech_ = true;
+    if (speech_ && prob_q8_ < VAD_SPEECH_OFF) speech_ = false;
+
+    // 5. 发布：{ 帧序号低 16 位 | snr(7) | speech(1) | prob(8) }
+    uint32_t snr_db = (uint32_t)std::max<int32_t>(0, std::min<int32_t>(127, snr_db_q8 >> 8));
+    uint32_t packed = ((uint32_t)(index & 0xFFFF) << 16) | (snr_db << 9) | ((uint32_t)speech_ << 8) | (uint32_t)prob_q8_;
+    results_[index % VAD_HISTORY].store(packed, std::memory_order_relaxed);
+    next_index_.store(index + 1, std::memory_order_release);
+}
+
+bool VadEngine::Query(uint64_t begin, uint64_t end, VadResult& out) const {
+    out = VadResult();
+    if (end <= begin) return false;
+
+    uint64_t next = next_index_.load(std::memory_order_acquire);
+    uint64_t first = begin / VAD_FRAME_SAMPLES;
+    uint64_t last = (end - 1) / VAD_FRAME_SAMPLES;
+    // 还没处理到的部分不算；太旧 (已经被覆盖) 的部分跳过
+    if (last >= next) last = next - 1;
+    if (next > VAD_HISTORY && first < next - VAD_HISTORY) first = next - VAD_HISTORY;
+    if (next == 0 || first > last) return false;
+
+    for (uint64_t i = first; i <= last; i++) {
+        uint32_t packed = results_[i % VAD_HISTORY].load(std::memory_order_relaxed);
+        // 读的时候写者可能已经套圈，帧序号对不上就跳过
+        if ((packed >> 16) != (uint32_t)(i & 0xFFFF)) continue;
+        out.prob = std::max<uint8_t>(out.prob, (uint8_t)(packed & 0xFF));
+        out.speech = out.speech || ((packed >> 8) & 1);
+        out.snr_db = std::max<int>(out.snr_db, (int)((packed >> 9) & 0x7F));
+        out.frames++;
+    }
+    return out.frames > 0;
+}
+
+int VadEngine::NoiseFloorDb(int band) const {
+    // 满幅正弦的平均能量约 2^30 (每个子带再减半)，以 2^30 作为 0dBFS
+    return (int)(VAD_LOG2_TO_DB_Q8(bands_[band & 1].floor_q8 - 30 * 256) >> 8);
+}
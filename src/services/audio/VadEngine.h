@@ -0,0 +1,82 @@
+/**
+ * @file VadEngine.h
+ * @brief 自适应语音活动检测 (噪声底跟踪 + 子带能量 + 迟滞)，全定点
+ *
+ * 固定的 RMS 阈值在吵的厨房里永远等不到 "静音"，在安静的房间里又听不到小声说话。这里改成相对噪声底判断:
+ * 1. 每 VAD_FRAME_SAMPLES (10ms) 一帧，用一阶差分把信号分成低/高两个子带 (x[n]+x[n-1] / x[n]-x[n-1])，
+ *    浊音的能量在低带，s/sh 这类清音在高带；两个子带各自算能量并取整数 log2 (Q8)。
+ * 2. 每个子带单独跟踪噪声底 (log 域)：能量更低时快速跟下去，更高时每帧只抬 VAD_FLOOR_RISE_Q8，
+ *    持续的背景噪声 (抽油烟机、电视) 几秒后就成了新的底，说话的几秒钟里底几乎不动。
+ * 3. 两个子带中信噪比较高的一个 (dB) 线性映射成 0..255 的语音概率，快升慢降地平滑；
+ *    概率超过 VAD_SPEECH_ON 进入 "说话"，低于 VAD_SPEECH_OFF 才退出 (迟滞)，不会在一个字中间来回跳。
+ * 4. 能量低于 VAD_MIN_RMS 的帧概率直接为 0 (数字静音/极安静时噪声底很低，避免把底噪放大成 "说话")。
+ *
+ * 录音线程对每个周期调用 Process()，噪声底在待机时也一直在跟踪，唤醒后的第一帧就有可靠的估计。
+ * 周期不必是帧长的整数倍，不满一帧的尾巴留到下一个周期拼上。
+ * 结果按录音位置 (CaptureRing 的绝对样本序号) 存进一个无锁的小历史表，
+ * 消费者 (ListeningState) 用自己游标读到的区间调用 Query() 取结果，不用自己再算一遍。
+ */
+
+#ifndef VAD_ENGINE_H
+#define VAD_ENGINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// VAD 的帧长 (10ms @ 16kHz)，和 ALSA 周期无关
+#define VAD_FRAME_SAMPLES 160
+// 保留多少帧的结果供查询 (必须是 2 的幂；1024 帧 ≈ 10 秒)
+#define VAD_HISTORY 1024
+
+// 一段录音的 VAD 结果
+struct VadResult {
+    uint8_t prob = 0;       // 区间内最大的语音概率 (0..255)
+    bool speech = false;    // 区间内有没有处于 "说话" 状态的帧 (带迟滞)
+    int snr_db = 0;         // 区间内最大的子带信噪比 (dB)
+    unsigned int frames = 0; // 覆盖了多少个 VAD 帧
+};
+
+class VadEngine {
+public:
+    explicit VadEngine(unsigned int sample_rate = 16000);
+
+    VadEngine(const VadEngine&) = delete;
+    void operator=(const VadEngine&) = delete;
+
+    // [录音线程] 噪声底重新估计
+    void Reset();
+
+    // [录音线程] 处理从 start_pos 开始的 n 个样本 (任意长度，必须紧接着上一次的结尾)
+    void Process(const int16_t* pcm, size_t n, uint64_t start_pos);
+
+    // [任意线程] [begin, end) 这段录音的结果；还没处理到或已经太旧时返回 false
+    bool Query(uint64_t begin, uint64_t end, VadResult& out) const;
+
+    // 当前噪声底 (低/高子带，dB，相对满幅 0dBFS)，调试用
+    int NoiseFloorDb(int band) const;
+
+private:
+    struct Band {
+        int32_t floor_q8;   // 噪声底，log2(能量) 的 Q8
+        int32_t last_q8;    // 最近一帧
+    };
+
+    void ProcessFrame(const int16_t* pcm, uint64_t index);
+
+    unsigned int rate_;
+    bool primed_;
+    int16_t prev_;          // 上一帧的最后一个样本 (一阶差分跨帧)
+    int16_t pending_[VAD_FRAME_SAMPLES];  // 上个周期剩下的不满一帧的样本
+    size_t pending_count_;
+    Band bands_[2];
+    int32_t prob_q8_;       // 平滑后的概率 (0..255)
+    bool speech_;
+
+    // 结果历史：按帧序号取模存放，打包成 { 帧序号低 16 位 | snr(7) | speech(1) | prob(8) }，
+    // 读者用帧序号校验，写者只有录音线程
+    std::atomic<uint32_t> results_[VAD_HISTORY];
+    std::atomic<uint64_t> next_index_;   // 下一个要写的帧序号 (之前的都已发布)
+};
+
+#endif // VAD_ENGINE_H
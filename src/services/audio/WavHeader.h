@@ -0,0 +1,45 @@
+/**
+ * @file WavHeader.h
+ * @brief 16bit 单声道 PCM 的 44 字节 WAV 文件头
+ *
+ * 录音文件 (WavWriter) 和内存录音 (UtteranceBuffer) 共用：
+ * 先放一个占位头，录完知道数据长度后再用 MakeWavHeader() 回填。
+ */
+
+#ifndef WAV_HEADER_H
+#define WAV_HEADER_H
+
+#include <cstdint>
+
+// 定义 WAV 文件头偏移量 (44字节)
+#define WAV_HEADER_SIZE 44
+
+struct WavHeader {
+    char riff[4] = {'R', 'I', 'F', 'F'};
+    uint32_t overall_size = 0;  // 文件总大小 - 8
+    char wave[4] = {'W', 'A', 'V', 'E'};
+    char fmt_chunk_marker[4] = {'f', 'm', 't', ' '};
+    uint32_t length_of_fmt = 16;
+    uint16_t format_type = 1;   // 1 = PCM
+    uint16_t channels = 1;      // 单声道 (注意：我们要存的是单声道)
+    uint32_t sample_rate = 16000;
+    uint32_t byterate = 16000 * 16 * 1 / 8; // rate * bits * ch / 8
+    uint16_t block_align = 16 * 1 / 8;      // bits * ch / 8
+    uint16_t bits_per_sample = 16;
+    char data_chunk_header[4] = {'d', 'a', 't', 'a'};
+    uint32_t data_size = 0;     // 纯音频数据大小
+};
+
+static_assert(sizeof(WavHeader) == WAV_HEADER_SIZE, "WavHeader must be 44 bytes");
+
+// 按采样率和数据长度 (字节) 生成完整的文件头
+inline WavHeader MakeWavHeader(uint32_t sample_rate, uint32_t data_size) {
+    WavHeader header;
+    header.sample_rate = sample_rate;
+    header.byterate = sample_rate * 16 * 1 / 8;
+    header.data_size = data_size;
+    header.overall_size = data_size + 36;
+    return header;
+}
+
+#endif // WAV_HEADER_H
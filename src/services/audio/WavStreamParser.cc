@@ -0,0 +1,193 @@
+#include "WavStreamParser.h"
+#include "AudioKernels.h"
+#include <cstdio>
+#include <cstring>
+
+// 头部 (含 LIST 等附加 chunk) 最多攒这么多字节，还没遇到 data chunk 就认为数据有问题
+#define WAV_MAX_HEADER_BYTES 4096
+
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_IMA_ADPCM 0x11
+#define ADPCM_BLOCK_HEADER 4
+
+static uint32_t ReadLE32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t ReadLE16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+WavStreamParser::WavStreamParser() {
+    Reset();
+}
+
+void WavStreamParser::Reset() {
+    state_ = kHeader;
+    header_.clear();
+    carry_len_ = 0;
+    rate_ = 0;
+    channels_ = 0;
+    format_ = 0;
+    block_align_ = 0;
+    block_pos_ = 0;
+}
+
+bool WavStreamParser::Feed(const void* data, size_t size, std::vector<int16_t>& out) {
+    const uint8_t* bytes = (const uint8_t*)data;
+
+    switch (state_) {
+        case kHeader:
+            header_.insert(header_.end(), bytes, bytes + size);
+            return ParseHeader(out);
+        case kData:
+            if (format_ == WAV_FORMAT_IMA_ADPCM) {
+                EmitAdpcm(bytes, size, out);
+            } else {
+                EmitPcm(bytes, size, out);
+            }
+            return true;
+        case kError:
+            break;
+    }
+    return false;
+}
+
+bool WavStreamParser::ParseHeader(std::vector<int16_t>& out) {
+    if (header_.size() < 12) return true;  // 等更多数据
+    if (memcmp(header_.data(), "RIFF", 4) != 0 || memcmp(header_.data() + 8, "WAVE", 4) != 0) {
+        printf("[Audio] WavStream: not a RIFF/WAVE stream\n");
+        state_ = kError;
+        return false;
+    }
+
+    // 依次走过每个 chunk，直到 data；任何一个 chunk 还没收全就等下一块
+    size_t pos = 12;
+    unsigned int bits = 0;
+    while (pos + 8 <= header_.size()) {
+        const uint8_t* chunk = header_.data() + pos;
+        uint32_t chunk_size = ReadLE32(chunk + 4);
+
+        if (memcmp(chunk, "data", 4) == 0) {
+            bool pcm_ok = format_ == WAV_FORMAT_PCM && bits == 16 && channels_ >= 1 && channels_ <= 2;
+            bool adpcm_ok = format_ == WAV_FORMAT_IMA_ADPCM && bits == 4 && channels_ == 1 &&
+                            block_align_ > ADPCM_BLOCK_HEADER;
+            if (!pcm_ok && !adpcm_ok) {
+                printf("[Audio] WavStream: unsupported format (format: 0x%x, ch: %u, bits: %u)\n",
+                       format_, channels_, bits);
+                state_ = kError;
+                return false;
+            }
+            state_ = kData;
+            size_t pcm_start = pos + 8;
+            Feed(header_.data() + pcm_start, header_.size() - pcm_start, out);
+            header_.clear();
+            header_.shrink_to_fit();
+            return true;
+        }
+
+        // chunk 按偶数字节对齐
+        size_t next = pos + 8 + chunk_size + (chunk_size & 1);
+        if (next > header_.size()) break;
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16) {
+            format_ = ReadLE16(chunk + 8);
+            channels_ = ReadLE16(chunk + 10);
+            rate_ = ReadLE32(chunk + 12);
+            block_align_ = ReadLE16(chunk + 20);
+            bits = ReadLE16(chunk + 22);
+            if (format_ != WAV_FORMAT_PCM && format_ != WAV_FORMAT_IMA_ADPCM) {
+                printf("[Audio] WavStream: only PCM / IMA-ADPCM are supported (format: 0x%x)\n", format_);
+                state_ = kError;
+                return false;
+            }
+        }
+        pos = next;
+    }
+
+    if (header_.size() > WAV_MAX_HEADER_BYTES) {
+        printf("[Audio] WavStream: no data chunk in the first %d bytes\n", WAV_MAX_HEADER_BYTES);
+        state_ = kError;
+        return false;
+    }
+    // 还没遇到 data chunk 时，fmt 解析出的结果下次会重新解析，这里先清掉
+    channels_ = 0;
+    rate_ = 0;
+    format_ = 0;
+    block_align_ = 0;
+    return true;
+}
+
+void WavStreamParser::EmitPcm(const uint8_t* data, size_t size, std::vector<int16_t>& out) {
+    const size_t frame_bytes = channels_ * sizeof(int16_t);
+
+    // 先把上一块留下的半帧补完整
+    if (carry_len_ > 0) {
+        size_t need = frame_bytes - carry_len_;
+        size_t take = size < need ? size : need;
+        memcpy(carry_ + carry_len_, data, take);
+        carry_len_ += take;
+        data += take;
+        size -= take;
+        if (carry_len_ < frame_bytes) return;
+        // 先清零再递归，避免重复进入这个分支
+        uint8_t frame[4];
+        memcpy(frame, carry_, frame_bytes);
+        carry_len_ = 0;
+        EmitPcm(frame, frame_bytes, out);
+    }
+
+    size_t frames = size / frame_bytes;
+    size_t old_size = out.size();
+    if (channels_ == 1) {
+        out.resize(old_size + frames);
+        memcpy(out.data() + old_size, data, frames * frame_bytes);
+    } else {
+        // 网络数据不保证 2 字节对齐，先拷进输出的尾部再原地混成单声道
+        out.resize(old_size + frames * 2);
+        memcpy(out.data() + old_size, data, frames * frame_bytes);
+        AudioKernels::MixDown(out.data() + old_size, out.data() + old_size, frames);
+        out.resize(old_size + frames);
+    }
+
+    size_t rest = size - frames * frame_bytes;
+    memcpy(carry_, data + frames * frame_bytes, rest);
+    carry_len_ = rest;
+}
+
+// IMA-ADPCM (WAV 格式 0x11，单声道)：每块 = 预测值(2) + 步长索引(1) + 保留(1) + 每字节两个样本 (低半字节在前)，
+// 块头里的预测值本身就是块的第一个样本
+void WavStreamParser::EmitAdpcm(const uint8_t* data, size_t size, std::vector<int16_t>& out) {
+    // 上限：每个数据字节出两个样本，块头 4 字节只出一个；先一次性扩好，解码时直接写指针
+    size_t old_size = out.size();
+    out.resize(old_size + size * 2);
+    int16_t* dst = out.data() + old_size;
+
+    while (size > 0) {
+        if (block_pos_ < ADPCM_BLOCK_HEADER) {
+            // 块头可能被网络分成两次送来，攒在 carry_ 里
+            carry_[block_pos_++] = *data++;
+            size--;
+            if (block_pos_ == ADPCM_BLOCK_HEADER) {
+                adpcm_.predictor = (int16_t)ReadLE16(carry_);
+                adpcm_.index = carry_[2];
+                ImaAdpcm::Clamp(adpcm_);
+                *dst++ = (int16_t)adpcm_.predictor;
+            }
+            continue;
+        }
+
+        // 块内的数据字节直接解码，不用等整块到齐
+        size_t take = block_align_ - block_pos_;
+        if (take > size) take = size;
+        for (size_t i = 0; i < take; i++) {
+            *dst++ = ImaAdpcm::Decode(adpcm_, data[i] & 0x0F);
+            *dst++ = ImaAdpcm::Decode(adpcm_, data[i] >> 4);
+        }
+        data += take;
+        size -= take;
+        block_pos_ += take;
+        if (block_pos_ == block_align_) block_pos_ = 0;
+    }
+    out.resize(dst - out.data());
+}
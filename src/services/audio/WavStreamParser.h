@@ -0,0 +1,62 @@
+/**
+ * @file WavStreamParser.h
+ * @brief 增量 WAV 解析器 (边下载边解析)
+ *
+ * 网络数据按任意大小的块到达，这里逐块喂进来:
+ * 1. 先攒齐 RIFF/WAVE 头，跳过 LIST 等无关 chunk，读出 fmt 里的声道数/采样率，直到遇到 data chunk。
+ * 2. 之后的字节直接当 PCM 输出；块边界上不完整的样本帧留到下一块再拼。
+ * 3. 支持 16bit PCM (单声道原样输出，双声道做 (L + R) / 2 混成单声道)，
+ *    以及单声道 IMA-ADPCM (WAV 格式 0x11，约为 PCM 的 1/4 大小，服务器 ffmpeg -acodec adpcm_ima_wav 生成)。
+ * 4. ADPCM 逐字节解码 (定点运算，见 ImaAdpcm.h)，不用等整块到齐；块头跨块边界时暂存在 carry_ 里，
+ *    解码不分配内存，样本直接写进调用方的 out。
+ * 5. data chunk 的长度字段不参与判断 (ffmpeg 管道输出时可能是 0 或 0xFFFFFFFF)，数据一直读到流结束。
+ */
+
+#ifndef WAV_STREAM_PARSER_H
+#define WAV_STREAM_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ImaAdpcm.h"
+
+class WavStreamParser {
+public:
+    WavStreamParser();
+
+    void Reset();
+
+    // 喂入一块数据，解析出的单声道样本追加到 out；格式不支持或头部损坏时返回 false
+    bool Feed(const void* data, size_t size, std::vector<int16_t>& out);
+
+    bool HeaderDone() const { return state_ == kData; }
+    bool Failed() const { return state_ == kError; }
+    unsigned int SampleRate() const { return rate_; }
+    unsigned int Channels() const { return channels_; }
+    // WAV 的格式码：1 = PCM, 0x11 = IMA-ADPCM
+    unsigned int Format() const { return format_; }
+
+private:
+    enum State { kHeader, kData, kError };
+
+    // 尝试从 header_ 里解析出完整的头，成功时把 data 之后多出来的字节作为 PCM 输出
+    bool ParseHeader(std::vector<int16_t>& out);
+    void EmitPcm(const uint8_t* data, size_t size, std::vector<int16_t>& out);
+    void EmitAdpcm(const uint8_t* data, size_t size, std::vector<int16_t>& out);
+
+    State state_;
+    std::vector<uint8_t> header_;  // 头部阶段攒下的字节
+    uint8_t carry_[4];             // 上一块末尾不完整的样本帧 (ADPCM: 不完整的块头)
+    size_t carry_len_;
+    unsigned int rate_;
+    unsigned int channels_;
+    unsigned int format_;
+
+    // ADPCM：每块的字节数 (块头 4 字节 + 每字节两个样本)、当前块已读的字节数、解码状态
+    size_t block_align_;
+    size_t block_pos_;
+    ImaAdpcm::State adpcm_;
+};
+
+#endif // WAV_STREAM_PARSER_H
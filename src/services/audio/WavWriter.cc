@@ -0,0 +1,197 @@
+#include "WavWriter.h"
+#include "WavHeader.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+// 没有新的整块数据时，写文件线程最多睡这么久再检查一次 (ms)
+#define WAV_WRITER_POLL_MS 20
+
+WavWriter::WavWriter(size_t buffer_samples, unsigned int sample_rate)
+    : ring_(buffer_samples), rate_(sample_rate) {
+    // 对齐到页，方便底层做整页写入
+    void* mem = nullptr;
+    if (posix_memalign(&mem, 4096, WAV_WRITE_BLOCK) != 0) mem = malloc(WAV_WRITE_BLOCK);
+    block_ = (uint8_t*)mem;
+}
+
+WavWriter::~WavWriter() {
+    Stop();
+    free(block_);
+}
+
+// ==========================================
+// 线程控制
+// ==========================================
+
+void WavWriter::Start() {
+    if (running_.load()) return;
+    running_.store(true);
+    thread_ = std::thread(&WavWriter::WriterLoop, this);
+}
+
+void WavWriter::Stop() {
+    if (running_.load()) {
+        running_.store(false);
+        cv_.notify_all();
+        if (thread_.joinable()) thread_.join();
+    }
+    Close();
+}
+
+void WavWriter::SetSyncPolicy(SyncPolicy policy, size_t sync_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policy_ = policy;
+    sync_bytes_ = sync_bytes;
+}
+
+void WavWriter::WriterLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_.load()) {
+        cv_.wait_for(lock, std::chrono::milliseconds(WAV_WRITER_POLL_MS));
+        if (fd_ >= 0) DrainLocked(false);
+    }
+}
+
+// ==========================================
+// 文件接口 (控制线程)
+// ==========================================
+
+bool WavWriter::Open(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ >= 0) CloseLocked();
+
+    fd_ = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        printf("[Audio] Error: Cannot create file %s\n", filename.c_str());
+        return false;
+    }
+    filename_ = filename;
+
+    // WAV 头占位放在第一块的开头，Close 时再回填
+    WavHeader dummy_header;
+    memcpy(block_, &dummy_header, sizeof(WavHeader));
+    block_fill_ = sizeof(WavHeader);
+    file_bytes_ = 0;
+    unsynced_bytes_ = 0;
+
+    // 上一个文件残留的数据不属于这个文件
+    ring_.Clear();
+    max_backlog_.store(0, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+    stall_us_.store(0, std::memory_order_relaxed);
+    max_stall_us_.store(0, std::memory_order_relaxed);
+
+    open_.store(true, std::memory_order_release);
+    return true;
+}
+
+long WavWriter::Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ < 0) return 0;
+    CloseLocked();
+    return (long)file_bytes_;
+}
+
+void WavWriter::CloseLocked() {
+    open_.store(false, std::memory_order_release);
+    DrainLocked(true);
+
+    // 回填真正的 WAV 头
+    uint64_t data_size = file_bytes_ > sizeof(WavHeader) ? file_bytes_ - sizeof(WavHeader) : 0;
+    WavHeader header = MakeWavHeader(rate_, (uint32_t)data_size);
+    if (pwrite(fd_, &header, sizeof(WavHeader), 0) != (ssize_t)sizeof(WavHeader)) {
+        printf("[Audio] Error: Failed to write WAV header of %s\n", filename_.c_str());
+    }
+
+    if (policy_ != kSyncNone) SyncLocked();
+
+    close(fd_);
+    fd_ = -1;
+}
+
+// ==========================================
+// 录音线程接口
+// ==========================================
+
+size_t WavWriter::Push(const int16_t* data, size_t n) {
+    if (ring_.Write(data, n) == 0) {
+        dropped_.fetch_add(n, std::memory_order_relaxed);
+        return 0;
+    }
+
+    size_t backlog = ring_.Available();
+    if (backlog > max_backlog_.load(std::memory_order_relaxed)) {
+        max_backlog_.store(backlog, std::memory_order_relaxed);
+    }
+    // 攒够一整块就叫醒写文件线程；不够的话它会在下次轮询时自己处理
+    if (backlog * sizeof(int16_t) >= WAV_WRITE_BLOCK) cv_.notify_one();
+    return n;
+}
+
+// ==========================================
+// 写文件线程
+// ==========================================
+
+void WavWriter::DrainLocked(bool final) {
+    for (;;) {
+        size_t room = (WAV_WRITE_BLOCK - block_fill_) / sizeof(int16_t);
+        size_t n = std::min(room, ring_.Available());
+        if (n == 0) break;
+        ring_.Read((int16_t*)(block_ + block_fill_), n);
+        block_fill_ += n * sizeof(int16_t);
+        if (block_fill_ == WAV_WRITE_BLOCK) FlushBlockLocked();
+    }
+    // 最后一块不满也要写出去
+    if (final && block_fill_ > 0) FlushBlockLocked();
+}
+
+void WavWriter::FlushBlockLocked() {
+    uint64_t start = NowUs();
+    ssize_t ret = write(fd_, block_, block_fill_);
+    RecordStall(start);
+
+    if (ret != (ssize_t)block_fill_) {
+        printf("[Audio] Error: Short write to %s (%zd / %zu bytes)\n", filename_.c_str(), ret, block_fill_);
+    }
+    if (ret > 0) {
+        file_bytes_ += ret;
+        unsynced_bytes_ += ret;
+    }
+    block_fill_ = 0;
+
+    if (policy_ == kSyncPeriodic && sync_bytes_ && unsynced_bytes_ >= sync_bytes_) SyncLocked();
+}
+
+void WavWriter::SyncLocked() {
+    if (unsynced_bytes_ == 0) return;
+    uint64_t start = NowUs();
+    fsync(fd_);
+    RecordStall(start);
+    unsynced_bytes_ = 0;
+}
+
+void WavWriter::RecordStall(uint64_t start_us) {
+    uint64_t us = NowUs() - start_us;
+    stall_us_.fetch_add(us, std::memory_order_relaxed);
+    if (us > max_stall_us_.load(std::memory_order_relaxed)) {
+        max_stall_us_.store((uint32_t)us, std::memory_order_relaxed);
+    }
+}
+
+uint64_t WavWriter::NowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+void WavWriter::LogStats() const {
+    printf("[Audio] WavWriter backlog: %zu, max backlog: %zu, dropped: %llu samples, stall: %llu us (max %u us)\n",
+           Backlog(), MaxBacklog(), (unsigned long long)DroppedSamples(),
+           (unsigned long long)StallUs(), MaxStallUs());
+}
@@ -0,0 +1,107 @@
+/**
+ * @file WavWriter.h
+ * @brief 后台 WAV 写文件线程 (Async WAV Writer)
+ *
+ * 录音线程不再直接 fwrite 到 SD 卡，只把样本 memcpy 进这里的 SPSC 环形缓冲区:
+ * 1. 写文件线程攒满一个对齐的大块 (WAV_WRITE_BLOCK 字节) 才调用一次 write()，
+ *    44 字节的 WAV 头占位也放在第一块里，所以每次写入的文件偏移都是块对齐的。
+ * 2. Close() 把剩余数据补写完，再用 pwrite 回填 WAV 头，按 SyncPolicy 决定是否 fsync。
+ * 3. 缓冲区满时丢弃新样本并计数，录音线程永远不会因为 Flash 慢而被卡住。
+ * 4. 积压 (backlog) 与 write/fsync 耗时 (stall) 作为统计信息对外暴露。
+ *
+ * 线程约定: Push() 只由录音线程调用；Open()/Close() 由控制线程调用，
+ * 调用期间录音线程不能 Push (由 AudioProcess 保证)。
+ */
+
+#ifndef WAV_WRITER_H
+#define WAV_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "RingBuffer.h"
+
+// 每次 write() 的块大小 (字节)，同时也是缓冲区的对齐粒度
+#define WAV_WRITE_BLOCK (32 * 1024)
+
+class WavWriter {
+public:
+    enum SyncPolicy {
+        kSyncNone = 0,      // 从不 fsync，交给内核回写
+        kSyncOnClose = 1,   // Close() 时 fsync 一次
+        kSyncPeriodic = 2,  // 每写满 sync_bytes 字节 fsync 一次，Close() 时再 fsync
+    };
+
+    // buffer_samples: 录音线程与写文件线程之间的缓冲区容量 (样本)
+    WavWriter(size_t buffer_samples, unsigned int sample_rate);
+    ~WavWriter();
+
+    WavWriter(const WavWriter&) = delete;
+    void operator=(const WavWriter&) = delete;
+
+    // 启动/停止后台写文件线程 (Stop 会先关闭正在写的文件)
+    void Start();
+    void Stop();
+
+    void SetSyncPolicy(SyncPolicy policy, size_t sync_bytes);
+
+    // [控制线程] 新建文件并写入 WAV 头占位；已有文件会先被 Close
+    bool Open(const std::string& filename);
+    // [控制线程] 写完缓冲区里的剩余数据、回填 WAV 头并关闭，返回文件总字节数 (未打开时返回 0)
+    long Close();
+    bool IsOpen() const { return open_.load(std::memory_order_acquire); }
+
+    // [录音线程] 只做 memcpy；缓冲区放不下时整段丢弃并记入 DroppedSamples()
+    size_t Push(const int16_t* data, size_t n);
+
+    // --- 统计信息 (可从其他线程读取，Open 时清零) ---
+    size_t Backlog() const { return ring_.Available(); }   // 还没写到文件的样本数
+    size_t MaxBacklog() const { return max_backlog_.load(std::memory_order_relaxed); }
+    uint64_t DroppedSamples() const { return dropped_.load(std::memory_order_relaxed); }
+    uint64_t StallUs() const { return stall_us_.load(std::memory_order_relaxed); }        // write/fsync 累计耗时
+    uint32_t MaxStallUs() const { return max_stall_us_.load(std::memory_order_relaxed); } // 单次最长耗时
+    void LogStats() const;
+
+private:
+    void WriterLoop();
+
+    // 以下函数要求持有 mutex_
+    void DrainLocked(bool final);
+    void FlushBlockLocked();
+    void SyncLocked();
+    void CloseLocked();
+    void RecordStall(uint64_t start_us);
+
+    static uint64_t NowUs();
+
+    SpscRing<int16_t> ring_;
+    unsigned int rate_;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    // 当前文件 (mutex_ 保护)
+    int fd_ = -1;
+    std::string filename_;
+    uint8_t* block_ = nullptr;      // WAV_WRITE_BLOCK 字节，按页对齐
+    size_t block_fill_ = 0;         // 块中已填充的字节数
+    uint64_t file_bytes_ = 0;       // 已经 write() 到文件的字节数
+    uint64_t unsynced_bytes_ = 0;   // 上次 fsync 之后写入的字节数
+    SyncPolicy policy_ = kSyncOnClose;
+    size_t sync_bytes_ = 0;
+
+    std::atomic<bool> open_{false};
+    std::atomic<size_t> max_backlog_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> stall_us_{0};
+    std::atomic<uint32_t> max_stall_us_{0};
+};
+
+#endif // WAV_WRITER_H
@@ -0,0 +1,77 @@
+#include "ChatReply.h"
+#include <cjson/cJSON.h>
+#include <cstdio>
+
+void ChatReply::Clear() {
+    text.clear();
+    user_text.clear();
+    audio_url.clear();
+    should_end_session = false;
+    asr_ms = -1;
+    llm_ms = -1;
+    tts_ms = -1;
+    options.clear();
+}
+
+// 字段不存在或类型不对时保持原值
+static void ReadString(const cJSON* obj, const char* key, std::string& out) {
+    const cJSON* item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsString(item) && item->valuestring) out.assign(item->valuestring);
+}
+
+static void ReadNumber(const cJSON* obj, const char* key, double& out) {
+    const cJSON* item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsNumber(item)) out = item->valuedouble;
+}
+
+bool ChatReply::Parse(const char* json, size_t len) {
+    Clear();
+
+    cJSON* root = cJSON_ParseWithLength(json, len);
+    if (!root || !cJSON_IsObject(root)) {
+        printf("[Network] Reply is not a JSON object\n");
+        cJSON_Delete(root);
+        return false;
+    }
+
+    ReadString(root, "text", text);
+    ReadString(root, "user_text", user_text);
+    ReadString(root, "audio_url", audio_url);
+    should_end_session = cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(root, "should_end_session"));
+
+    const cJSON* timing = cJSON_GetObjectItemCaseSensitive(root, "timing");
+    if (cJSON_IsObject(timing)) {
+        ReadNumber(timing, "asr_ms", asr_ms);
+        ReadNumber(timing, "llm_ms", llm_ms);
+        ReadNumber(timing, "tts_ms", tts_ms);
+    }
+
+    const cJSON* opts = cJSON_GetObjectItemCaseSensitive(root, "options");
+    const cJSON* item = nullptr;
+    if (cJSON_IsObject(opts)) {
+        cJSON_ArrayForEach(item, opts) {
+            if (!item->string) continue;
+            if (cJSON_IsString(item) && item->valuestring) {
+                options[item->string] = item->valuestring;
+            } else if (cJSON_IsBool(item)) {
+                options[item->string] = cJSON_IsTrue(item) ? "true" : "false";
+            } else if (cJSON_IsNumber(item)) {
+                char buf[32];
+                if (item->valuedouble == (double)item->valueint) {
+                    snprintf(buf, sizeof(buf), "%d", item->valueint);
+                } else {
+                    snprintf(buf, sizeof(buf), "%g", item->valuedouble);
+                }
+                options[item->string] = buf;
+            }
+        }
+    }
+
+    cJSON_Delete(root);
+    return true;
+}
+
+std::string ChatReply::Option(const std::string& key, const std::string& def) const {
+    std::map<std::string, std::string>::const_iterator it = options.find(key);
+    return it == options.end() ? def : it->second;
+}
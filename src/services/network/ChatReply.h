@@ -0,0 +1,42 @@
+/**
+ * @file ChatReply.h
+ * @brief 服务器回复的元数据 (用 cJSON 解析一次，结果放进可复用的结构体)
+ *
+ * 服务器回复 (普通 JSON 或分帧回复里的 'J' 记录) 的字段:
+ *   text / user_text / audio_url / should_end_session
+ *   timing: { asr_ms, llm_ms, tts_ms }    服务器各阶段耗时，可选
+ *   options: { "codec": "...", ... }      每轮的扩展选项，可选；状态机按键名取用，
+ *                                         服务器新增选项不需要改解析代码
+ */
+
+#ifndef CHAT_REPLY_H
+#define CHAT_REPLY_H
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+struct ChatReply {
+    std::string text;              // AI 的回复文字
+    std::string user_text;         // 服务器识别出的用户语音
+    std::string audio_url;         // 两次往返模式下回复音频的下载地址
+    bool should_end_session = false;
+
+    // 服务器各阶段耗时 (ms)，回复里没有时为 -1
+    double asr_ms = -1;
+    double llm_ms = -1;
+    double tts_ms = -1;
+
+    // 扩展选项，值统一转成字符串 (数字按整数/小数格式化，布尔为 "true"/"false")
+    std::map<std::string, std::string> options;
+
+    // 清空字段 (字符串保留容量，每轮复用同一个结构体)
+    void Clear();
+    // 解析一段 JSON，成功返回 true；失败时字段保持 Clear() 之后的状态
+    bool Parse(const char* json, size_t len);
+    bool Parse(const std::string& json) { return Parse(json.data(), json.size()); }
+    // 取扩展选项，没有时返回 def
+    std::string Option(const std::string& key, const std::string& def = "") const;
+};
+
+#endif // CHAT_REPLY_H
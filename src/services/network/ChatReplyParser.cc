@@ -0,0 +1,127 @@
+#include "ChatReplyParser.h"
+#include <cstdio>
+#include <cstring>
+
+#define REPLY_MAGIC "CHT1"
+#define REPLY_MAGIC_LEN 4
+#define RECORD_HEADER_LEN 5
+// JSON 元数据的上限，超过认为数据有问题
+#define REPLY_MAX_JSON_BYTES (64 * 1024)
+// 一句文字的上限
+#define REPLY_MAX_CLIP_TEXT_BYTES 4096
+
+ChatReplyParser::ChatReplyParser() {
+    Reset(nullptr, nullptr, nullptr);
+}
+
+void ChatReplyParser::Reset(AudioSink sink, EndHook on_end, void* userdata, ClipHook on_clip) {
+    sink_ = sink;
+    on_end_ = on_end;
+    on_clip_ = on_clip;
+    userdata_ = userdata;
+    head_len_ = 0;
+    magic_done_ = false;
+    type_ = 0;
+    remain_ = 0;
+    in_record_ = false;
+    json_.clear();
+    clip_.clear();
+    {
+        std::lock_guard<std::mutex> lock(text_mutex_);
+        clip_text_.clear();
+    }
+    clips_.store(0);
+    json_ready_.store(false);
+    failed_.store(false);
+    ended_.store(false);
+}
+
+bool ChatReplyParser::Sink(const void* data, size_t size, void* parser) {
+    return ((ChatReplyParser*)parser)->Feed(data, size);
+}
+
+bool ChatReplyParser::Fail(const char* why) {
+    printf("[Network] Chat reply: %s\n", why);
+    failed_.store(true, std::memory_order_release);
+    return false;
+}
+
+bool ChatReplyParser::Feed(const void* data, size_t size) {
+    const uint8_t* p = (const uint8_t*)data;
+    if (Failed()) return false;
+
+    while (size > 0) {
+        // 1. 魔数 / 记录头：可能被拆在两块数据里，先攒齐
+        if (!in_record_) {
+            if (ended_.load(std::memory_order_relaxed)) return true;  // 'E' 之后的数据忽略
+            size_t need = (magic_done_ ? RECORD_HEADER_LEN : REPLY_MAGIC_LEN) - head_len_;
+            size_t take = size < need ? size : need;
+            memcpy(head_ + head_len_, p, take);
+            head_len_ += take;
+            p += take;
+            size -= take;
+            if (take < need) return true;
+            head_len_ = 0;
+
+            if (!magic_done_) {
+                if (memcmp(head_, REPLY_MAGIC, REPLY_MAGIC_LEN) != 0) return Fail("not a framed reply");
+                magic_done_ = true;
+                continue;
+            }
+
+            type_ = head_[0];
+            remain_ = (size_t)head_[1] | ((size_t)head_[2] << 8) | ((size_t)head_[3] << 16) | ((size_t)head_[4] << 24);
+            if (type_ == 'J' && remain_ > REPLY_MAX_JSON_BYTES) return Fail("metadata too large");
+            if (type_ == 'C' && remain_ > REPLY_MAX_CLIP_TEXT_BYTES) return Fail("clip text too large");
+            if (type_ == 'E') {
+                ended_.store(true, std::memory_order_release);
+                continue;
+            }
+            in_record_ = true;
+            if (remain_ > 0) continue;
+        }
+
+        // 2. 记录内容：音频直接转交，不在这里攒
+        size_t take = size < remain_ ? size : remain_;
+        if (type_ == 'J') {
+            json_.append((const char*)p, take);
+        } else if (type_ == 'C') {
+            clip_.append((const char*)p, take);
+        } else if (type_ == 'A' && sink_ && take > 0) {
+            if (!sink_(p, take, userdata_)) return Fail("audio sink rejected data");
+        }
+        p += take;
+        size -= take;
+        remain_ -= take;
+
+        if (remain_ == 0) {
+            in_record_ = false;
+            if (type_ == 'J') json_ready_.store(true, std::memory_order_release);
+            if (type_ == 'C') StartClip();
+        }
+    }
+    return true;
+}
+
+// 新的一句：先让播放端准备好解析新的 WAV，再记下文字
+void ChatReplyParser::StartClip() {
+    if (on_clip_) on_clip_(userdata_);
+    unsigned int n = clips_.load(std::memory_order_relaxed) + 1;
+    printf("[Network] Chat reply: clip %u \"%s\"\n", n, clip_.c_str());
+    {
+        std::lock_guard<std::mutex> lock(text_mutex_);
+        clip_text_ += clip_;
+    }
+    clip_.clear();
+    clips_.store(n, std::memory_order_release);
+}
+
+std::string ChatReplyParser::ClipText() const {
+    std::lock_guard<std::mutex> lock(text_mutex_);
+    return clip_text_;
+}
+
+void ChatReplyParser::Finish() {
+    if (magic_done_ && !Ended() && !Failed()) printf("[Network] Chat reply: stream ended without an end record\n");
+    if (on_end_) on_end_(userdata_);
+}
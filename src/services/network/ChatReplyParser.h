@@ -0,0 +1,93 @@
+/**
+ * @file ChatReplyParser.h
+ * @brief 单次往返的对话回复解析 (JSON + 音频在同一个响应里)
+ *
+ * 请求带上 "X-Reply-Format: framed" 时，服务器不再只回 JSON 让设备再去 GET audio_url，
+ * 而是把元数据和回复音频放进同一个响应体，省掉一次完整的请求/响应往返:
+ *
+ *   "CHT1"                            4 字节魔数
+ *   { type(1) | length(4, LE) | payload } ...
+ *
+ *   'J'  JSON 元数据 (text / should_end_session ...)，总是第一条
+ *   'A'  音频数据 (WAV 文件的一段，按顺序拼起来就是完整的 WAV)，可以有多条
+ *   'C'  新的一段音频 (payload = 这一句的文字)，之后的 'A' 属于一个新的 WAV 文件；
+ *        按句流水线模式 (CHAT_REPLY_PIPELINE_HEADER) 下服务器每合成好一句就发一段
+ *   'E'  结束 (length = 0)
+ *   其他类型跳过，方便以后扩展
+ *
+ * Feed() 在网络线程里逐块调用：音频一到就交给 audio sink (边下边播)，不等整条记录收完；
+ * 主循环通过 JsonReady()/Json() 读取元数据。请求结束 (成功/失败/取消) 时调用 Finish()，
+ * 它总会调用一次 on_end，播放端据此结束流。每条 'C' 收完时调用 on_clip，播放端据此开始解析新的 WAV。
+ */
+
+#ifndef CHAT_REPLY_PARSER_H
+#define CHAT_REPLY_PARSER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// 请求头：要求服务器按上面的格式回复
+#define CHAT_REPLY_FRAMED_HEADER "X-Reply-Format: framed"
+// 请求头：按句流水线，LLM 每生成一句就合成、发送一段 ('C' + 'A'...)
+#define CHAT_REPLY_PIPELINE_HEADER "X-Reply-Pipeline: sentences"
+
+class ChatReplyParser {
+public:
+    typedef bool (*AudioSink)(const void* data, size_t size, void* userdata);
+    typedef void (*EndHook)(void* userdata);
+    typedef void (*ClipHook)(void* userdata);
+
+    ChatReplyParser();
+
+    ChatReplyParser(const ChatReplyParser&) = delete;
+    void operator=(const ChatReplyParser&) = delete;
+
+    // [主循环] 开始新的一轮，请求提交之前调用
+    void Reset(AudioSink sink, EndHook on_end, void* userdata, ClipHook on_clip = nullptr);
+
+    // [网络线程] 喂入一块响应数据；格式错误或 audio sink 返回 false 时返回 false (中止下载)
+    bool Feed(const void* data, size_t size);
+    // [网络线程] 请求结束
+    void Finish();
+    // 作为 NetRequest 的 DataSink 使用，userdata 是 ChatReplyParser*
+    static bool Sink(const void* data, size_t size, void* parser);
+
+    // --- 主循环读取 ---
+    bool JsonReady() const { return json_ready_.load(std::memory_order_acquire); }
+    const std::string& Json() const { return json_; }   // JsonReady() 之后才有效
+    bool Failed() const { return failed_.load(std::memory_order_acquire); }
+    bool Ended() const { return ended_.load(std::memory_order_acquire); }
+    // 按句流水线：已经收到的段数，以及这些句子拼起来的文字
+    unsigned int Clips() const { return clips_.load(std::memory_order_acquire); }
+    std::string ClipText() const;
+
+private:
+    bool Fail(const char* why);
+    void StartClip();
+
+    AudioSink sink_ = nullptr;
+    EndHook on_end_ = nullptr;
+    ClipHook on_clip_ = nullptr;
+    void* userdata_ = nullptr;
+
+    uint8_t head_[5];          // 魔数 / 记录头攒到一半时先存这里
+    size_t head_len_ = 0;
+    bool magic_done_ = false;
+    uint8_t type_ = 0;
+    size_t remain_ = 0;        // 当前记录还没收完的字节数
+    bool in_record_ = false;
+
+    std::string json_;
+    std::string clip_;                 // 正在收的 'C' 记录 (一句的文字)
+    mutable std::mutex text_mutex_;
+    std::string clip_text_;            // text_mutex_ 保护：已收到的句子
+    std::atomic<unsigned int> clips_{0};
+    std::atomic<bool> json_ready_{false};
+    std::atomic<bool> failed_{false};
+    std::atomic<bool> ended_{false};
+};
+
+#endif // CHAT_REPLY_PARSER_H
@@ -1,31 +1,41 @@
 #include "services/network/NetworkClient.h"
+#include "common/config.h"
+#include "services/audio/WavStreamParser.h"
 #include <curl/curl.h>
 #include <iostream>
 #include <stdio.h>
 #include <string>
+#include <cstring>
+#include <algorithm>
 
-// 回调：把收到的数据拼接成 string (用于接收 JSON)
-static size_t WriteStringCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-    ((std::string*)userp)->append((char*)contents, size * nmemb);
-    return size * nmemb;
+// 上传/下载的超时 (ms)，和原来阻塞版本的 30 秒一致
+#define REQUEST_TIMEOUT_MS 30000L
+// 流式上传的总超时 (ms)：包含用户说话的时间，所以比普通上传长
+#define STREAM_TIMEOUT_MS 60000L
+// Ping / 预连接的超时 (ms)
+#define PING_TIMEOUT_MS 5000L
+
+// 上传请求共用的回复相关 header：分帧回复 (可选按句流水线)、回复音频的编码
+static struct curl_slist* AppendReplyHeaders(struct curl_slist* headers, ChatReplyParser* reply) {
+    if (reply) headers = curl_slist_append(headers, CHAT_REPLY_FRAMED_HEADER);
+#if REPLY_SENTENCE_PIPELINE
+    if (reply) headers = curl_slist_append(headers, CHAT_REPLY_PIPELINE_HEADER);
+#endif
+#if REPLY_AUDIO_ADPCM
+    headers = curl_slist_append(headers, "X-Reply-Codec: adpcm");
+#endif
+    return headers;
 }
 
 // 回调：把收到的数据写入文件 (用于下载音频)
-static size_t WriteFileCallback(void *ptr, size_t size, size_t nmemb, void *stream) {
-    return fwrite(ptr, size, nmemb, (FILE *)stream);
+static bool WriteFileSink(const void* data, size_t size, void* userdata) {
+    return fwrite(data, 1, size, (FILE*)userdata) == size;
 }
 
-// [新增] 简单的 JSON 布尔值解析辅助函数
-// 查找 "key": true 或 "key":true
-static bool ParseBoolFromJson(const std::string& json, const std::string& key) {
-    std::string pattern1 = "\"" + key + "\": true";
-    std::string pattern2 = "\"" + key + "\":true";
-    
-    if (json.find(pattern1) != std::string::npos || 
-        json.find(pattern2) != std::string::npos) {
-        return true;
-    }
-    return false;
+NetworkClient::NetworkClient() : upload_codec_(CHAT_UPLOAD_CODEC) {}
+
+NetworkClient::~NetworkClient() {
+    StreamAbort();
 }
 
 void NetworkClient::init() {
@@ -38,106 +48,300 @@ void NetworkClient::SetServerIP(const std::string& ip) {
 
 std::string NetworkClient::SendRequest(const std::string& endpoint) {
     // 简单的 GET 请求测试 (用于 Ping)
-    CURL* curl = curl_easy_init();
-    std::string response;
-    if(curl) {
-        std::string url = "http://" + server_ip_ + ":" + std::to_string(port_) + "/" + endpoint;
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteStringCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 5L);
-        curl_easy_perform(curl);
-        curl_easy_cleanup(curl);
+    CURL* curl = pool_.Acquire();
+    if (!curl) return "";
+
+    std::string url = "http://" + server_ip_ + ":" + std::to_string(port_) + "/" + endpoint;
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+
+    NetRequestPtr req = worker_.Submit(std::make_shared<NetRequest>(curl, PING_TIMEOUT_MS, &pool_));
+    worker_.Wait(req);
+    return req->Body();
+}
+
+// 预连接：发一个 HEAD 请求，结束后连接留在共享连接缓存里 (keep-alive)，
+// 紧接着的上传/下载直接复用，TCP 握手和用户说话同时进行。不关心结果，不等待
+void NetworkClient::Prewarm() {
+    CURL* curl = pool_.Acquire();
+    if (!curl) return;
+
+    std::string url = "http://" + server_ip_ + ":" + std::to_string(port_) + NET_PREWARM_ENDPOINT;
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+
+    worker_.Submit(std::make_shared<NetRequest>(curl, PING_TIMEOUT_MS, &pool_));
+}
+
+// 上传的公共部分：mime 里的 "audio" 字段已经由调用方填好 (文件或内存)，
+// 这里负责设置 URL/header，然后交给网络线程；curl/mime/header 由 NetRequest 负责释放
+NetRequestPtr NetworkClient::PostAudioAsync(CURL* curl, curl_mime* mime, ChatReplyParser* reply) {
+    std::string url = "http://" + server_ip_ + ":" + std::to_string(port_) + "/chat";
+
+    // 定义 header 链表指针
+    struct curl_slist *headerlist = NULL;
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    
+    // [核心修改]
+    // 1. 添加 "Expect:" 头部（值为空）,禁用复杂传输方式
+    headerlist = curl_slist_append(headerlist, "Expect:");
+    headerlist = curl_slist_append(headerlist, "Transfer-Encoding:");
+    headerlist = AppendReplyHeaders(headerlist, reply);
+    // 2. 将 header 应用到 curl
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headerlist);
+    curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime);
+
+    NetRequestPtr req = std::make_shared<NetRequest>(curl, REQUEST_TIMEOUT_MS, &pool_);
+    req->SetMime(mime);
+    req->SetHeaders(headerlist);
+    AttachReply(*req, reply);
+    return worker_.Submit(req);
+}
+
+// 回复走分帧格式：响应体交给解析器，请求结束 (无论成败) 时通知它
+void NetworkClient::AttachReply(NetRequest& req, ChatReplyParser* reply) {
+    if (reply) req.SetSink(ChatReplyParser::Sink, reply);
+    req.OnComplete([this, reply](NetRequest& done) {
+        // 服务器不认识这个编码：之后的上传都改传 PCM，这一次的失败由调用方的整段重传兜底
+        if (done.HttpStatus() == 415 && UploadCodec() != AudioEncoder::kPcm) {
+            std::cerr << "⚠️ [Network] Server rejected upload codec, falling back to PCM." << std::endl;
+            SetUploadCodec(AudioEncoder::kPcm);
+        }
+        if (reply) reply->Finish();
+    });
+}
+
+// 每次上传打印压缩效果：原始/上传字节数和编码花的 CPU 时间
+void NetworkClient::LogUploadCodec(const AudioEncoder& encoder) const {
+    size_t in = encoder.InputBytes();
+    size_t out = encoder.OutputBytes();
+    std::cout << "[Network] Upload codec " << AudioEncoder::CodecName(encoder.GetCodec()) << ": "
+              << in << " -> " << out << " bytes (" << (in ? out * 100 / in : 0) << "%), encode "
+              << encoder.CpuUs() << " us CPU" << std::endl;
+}
+
+static bool ParseReplyJson(const std::string& json, ChatReply& out) {
+    if (!out.Parse(json)) return false;
+    if (out.should_end_session) {
+        std::cout << "✅ [Network] Exit signal received from Server." << std::endl;
     }
-    return response;
+    return true;
+}
+
+bool NetworkClient::ParseReply(const NetRequest& req, ChatReply& out) {
+    out.Clear();
+    // 4xx/5xx 的响应体是错误信息，不是回复
+    if (!req.Succeeded() || req.HttpStatus() >= 400 || req.Body().empty()) return false;
+    return ParseReplyJson(req.Body(), out);
+}
+
+bool NetworkClient::ParseReply(const ChatReplyParser& reply, ChatReply& out) {
+    out.Clear();
+    if (!reply.JsonReady()) return false;
+    return ParseReplyJson(reply.Json(), out);
+}
+
+// 阻塞接口的返回值：原始 JSON (失败时为空)，should_end_session 放进输出参数
+static std::string BlockingReply(const NetRequest& req, bool& out_should_exit) {
+    ChatReply reply;
+    out_should_exit = false;
+    if (!NetworkClient::ParseReply(req, reply)) return "";
+    out_should_exit = reply.should_end_session;
+    return req.Body();
 }
 
 // [核心实现] 上传音频
 std::string NetworkClient::SendAudio(const std::string& filepath, bool& out_should_exit) {
-    CURL* curl = curl_easy_init();
-    std::string response;
+    out_should_exit = false;
+
+    CURL* curl = pool_.Acquire();
+    if (!curl) return "";
+
+    curl_mime* mime = curl_mime_init(curl);
+    curl_mimepart* part = curl_mime_addpart(mime);
     
+    // 表单字段名 "audio"
+    curl_mime_name(part, "audio");
+    // 文件路径
+    curl_mime_filedata(part, filepath.c_str());
+
+    NetRequestPtr req = PostAudioAsync(curl, mime, nullptr);
+    worker_.Wait(req);
+    return BlockingReply(*req, out_should_exit);
+}
+
+// 从内存上传：数据直接交给 libcurl，不写 SD 卡也不再读回来
+std::string NetworkClient::SendAudio(const void* data, size_t size, const std::string& filename, bool& out_should_exit) {
     out_should_exit = false;
 
-    // 定义 header 链表指针
-    struct curl_slist *headerlist = NULL;
+    NetRequestPtr req = SendAudioAsync(data, size, filename);
+    if (!req) return "";
+    worker_.Wait(req);
+    return BlockingReply(*req, out_should_exit);
+}
 
-    if (curl) {
-        // 拼接 URL: http://IP:5000/chat
-        std::string url = "http://" + server_ip_ + ":" + std::to_string(port_) + "/chat";
-        
-        curl_mime* mime = curl_mime_init(curl);
-        curl_mimepart* part = curl_mime_addpart(mime);
-        
-        // 表单字段名 "audio"
-        curl_mime_name(part, "audio");
-        // 文件路径
-        curl_mime_filedata(part, filepath.c_str());
-
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        
-        // [核心修改]
-        // 1. 添加 "Expect:" 头部（值为空）,禁用复杂传输方式
-        headerlist = curl_slist_append(headerlist, "Expect:");
-        headerlist = curl_slist_append(headerlist, "Transfer-Encoding:");
-        // 2. 将 header 应用到 curl
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headerlist);
-
-        curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteStringCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        
-        // 超时时间
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L); 
-
-        CURLcode res = curl_easy_perform(curl);
-        if(res != CURLE_OK) {
-            std::cerr << "❌ [Network] Upload Error: " << curl_easy_strerror(res) << std::endl;
+NetRequestPtr NetworkClient::SendAudioAsync(const void* data, size_t size, const std::string& filename,
+                                            ChatReplyParser* reply) {
+    // 压缩上传：去掉 WAV 头，只编码 PCM；解析不了的数据原样上传
+    AudioEncoder::Codec codec = UploadCodec();
+    std::vector<uint8_t> encoded;
+    unsigned int sample_rate = 16000;
+    if (codec != AudioEncoder::kPcm) {
+        WavStreamParser wav;
+        std::vector<int16_t> pcm;
+        if (wav.Feed(data, size, pcm) && wav.HeaderDone()) {
+            AudioEncoder encoder(codec);
+            encoder.Encode(pcm.data(), pcm.size(), encoded);
+            encoder.Flush(encoded);
+            sample_rate = wav.SampleRate();
+            LogUploadCodec(encoder);
         } else {
-            if (ParseBoolFromJson(response, "should_end_session")) {
-                out_should_exit = true;
-                std::cout << "✅ [Network] Exit signal received from Server." << std::endl;
-            }
+            codec = AudioEncoder::kPcm;
         }
+    }
+
+    CURL* curl = pool_.Acquire();
+    if (!curl) return nullptr;
+
+    curl_mime* mime = curl_mime_init(curl);
+    curl_mimepart* part = curl_mime_addpart(mime);
 
-        // --- [清理] 别忘了释放 headerlist ---
-        curl_slist_free_all(headerlist);
-        
-        curl_mime_free(mime);
-        curl_easy_cleanup(curl);
+    curl_mime_name(part, "audio");
+    // curl_mime_data 会拷贝一份，调用方的缓冲区在返回后即可复用
+    if (codec == AudioEncoder::kPcm) {
+        curl_mime_data(part, (const char*)data, size);
+        curl_mime_type(part, "audio/wav");
+    } else {
+        curl_mime_data(part, (const char*)encoded.data(), encoded.size());
+        curl_mime_type(part, "application/octet-stream");
     }
-    return response;
+    // 服务端按上传文件处理 (request.files)，必须带文件名
+    curl_mime_filename(part, filename.c_str());
+
+    if (codec != AudioEncoder::kPcm) {
+        // 编码方式和采样率放在单独的表单字段里，服务器据此解码
+        part = curl_mime_addpart(mime);
+        curl_mime_name(part, "codec");
+        curl_mime_data(part, AudioEncoder::CodecName(codec), CURL_ZERO_TERMINATED);
+        part = curl_mime_addpart(mime);
+        curl_mime_name(part, "sample_rate");
+        curl_mime_data(part, std::to_string(sample_rate).c_str(), CURL_ZERO_TERMINATED);
+    }
+
+    return PostAudioAsync(curl, mime, reply);
 }
 
 // [核心实现] 下载文件
 bool NetworkClient::DownloadFile(const std::string& url_path, const std::string& save_path) {
-    CURL* curl = curl_easy_init();
-    bool success = false;
-
-    if (curl) {
-        FILE* fp = fopen(save_path.c_str(), "wb");
-        if (fp) {
-            std::string full_url = "http://" + server_ip_ + ":" + std::to_string(port_) + url_path;
-            
-            curl_easy_setopt(curl, CURLOPT_URL, full_url.c_str());
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteFileCallback);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
-            
-            // ✅ [Fix] 下载也增加超时时间，防止生成回复太慢
-            curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
-
-            CURLcode res = curl_easy_perform(curl);
-            if(res == CURLE_OK) {
-                success = true;
-            } else {
-                std::cerr << "❌ [Network] Download Error: " << curl_easy_strerror(res) << std::endl;
-            }
-
-            fclose(fp);
-        } else {
-            std::cerr << "❌ [Network] Cannot open file for writing: " << save_path << std::endl;
-        }
-        curl_easy_cleanup(curl);
+    FILE* fp = fopen(save_path.c_str(), "wb");
+    if (!fp) {
+        std::cerr << "❌ [Network] Cannot open file for writing: " << save_path << std::endl;
+        return false;
     }
+
+    // 和流式下载走同一条路，只是 sink 写文件
+    bool success = DownloadStream(url_path, WriteFileSink, fp);
+    fclose(fp);
     return success;
-}
\ No newline at end of file
+}
+
+// 流式下载：数据不落盘，边收边交给 sink
+bool NetworkClient::DownloadStream(const std::string& url_path, DataSink sink, void* userdata) {
+    NetRequestPtr req = DownloadStreamAsync(url_path, sink, userdata, nullptr);
+    if (!req) return false;
+    worker_.Wait(req);
+    return req->Succeeded();
+}
+
+NetRequestPtr NetworkClient::DownloadStreamAsync(const std::string& url_path, DataSink sink, void* userdata,
+                                                 NetRequest::Callback on_complete) {
+    CURL* curl = pool_.Acquire();
+    if (!curl) return nullptr;
+
+    std::string full_url = "http://" + server_ip_ + ":" + std::to_string(port_) + url_path;
+    curl_easy_setopt(curl, CURLOPT_URL, full_url.c_str());
+
+    NetRequestPtr req = std::make_shared<NetRequest>(curl, REQUEST_TIMEOUT_MS, &pool_);
+    req->SetSink(sink, userdata);
+    req->OnComplete(on_complete);
+    return worker_.Submit(req);
+}
+
+// ==========================================
+// 流式上传 (边说边传)
+// ==========================================
+
+bool NetworkClient::StreamBegin(const std::string& endpoint, unsigned int sample_rate, ChatReplyParser* reply) {
+    // 上一次的流式请求没人取结果 (会话中途结束)，先把它中止掉
+    StreamAbort();
+
+    CURL* curl = pool_.Acquire();
+    if (!curl) return false;
+
+    std::string url = "http://" + server_ip_ + ":" + std::to_string(port_) + endpoint;
+
+    struct curl_slist *headerlist = NULL;
+    // 不给长度 + 显式 chunked：libcurl 会按读回调给出的数据逐块发送
+    headerlist = curl_slist_append(headerlist, "Expect:");
+    headerlist = curl_slist_append(headerlist, "Transfer-Encoding: chunked");
+    headerlist = curl_slist_append(headerlist, "Content-Type: application/octet-stream");
+    std::string rate_header = "X-Sample-Rate: " + std::to_string(sample_rate);
+    headerlist = curl_slist_append(headerlist, rate_header.c_str());
+    // 一帧一帧地编码，凑满一块就发 (见 AudioEncoder.h)
+    stream_encoder_.Reset(UploadCodec());
+    std::string codec_header = std::string("X-Audio-Codec: ") + AudioEncoder::CodecName(stream_encoder_.GetCodec());
+    headerlist = curl_slist_append(headerlist, codec_header.c_str());
+    headerlist = AppendReplyHeaders(headerlist, reply);
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headerlist);
+
+    stream_ = std::make_shared<NetRequest>(curl, STREAM_TIMEOUT_MS, &pool_);
+    stream_->SetHeaders(headerlist);
+    stream_->UseStreamingBody();
+    AttachReply(*stream_, reply);
+    worker_.Submit(stream_);
+    return true;
+}
+
+void NetworkClient::StreamWrite(const void* data, size_t size) {
+    if (!stream_) return;
+    encode_buf_.clear();
+    stream_encoder_.Encode((const int16_t*)data, size / sizeof(int16_t), encode_buf_);
+    if (encode_buf_.empty()) return;  // 还没凑满一块
+    stream_->AppendBody(encode_buf_.data(), encode_buf_.size());
+    worker_.Resume(stream_);
+}
+
+void NetworkClient::StreamEnd() {
+    if (!stream_) return;
+    encode_buf_.clear();
+    stream_encoder_.Flush(encode_buf_);
+    if (!encode_buf_.empty()) stream_->AppendBody(encode_buf_.data(), encode_buf_.size());
+    stream_->EndBody();
+    worker_.Resume(stream_);
+    LogUploadCodec(stream_encoder_);
+}
+
+NetRequestPtr NetworkClient::StreamTake() {
+    NetRequestPtr req;
+    req.swap(stream_);
+    return req;
+}
+
+void NetworkClient::StreamAbort() {
+    NetRequestPtr req = StreamTake();
+    if (!req) return;
+    worker_.Cancel(req);
+    worker_.Wait(req);
+}
+
+std::string NetworkClient::StreamResult(bool& out_should_exit) {
+    out_should_exit = false;
+    NetRequestPtr req = StreamTake();
+    if (!req) return "";
+
+    worker_.Wait(req);
+    std::cout << "[Network] Stream finished (" << req->BodyBytesSent() << " bytes sent)." << std::endl;
+    return BlockingReply(*req, out_should_exit);
+}
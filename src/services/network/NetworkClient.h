@@ -1,8 +1,15 @@
 #ifndef NETWORK_CLIENT_H
 #define NETWORK_CLIENT_H
 
+#include <atomic>
+#include <cstddef>
 #include <string>
-#include <mutex>
+#include <vector>
+
+#include "NetworkWorker.h"
+#include "ChatReplyParser.h"
+#include "ChatReply.h"
+#include "services/audio/AudioEncoder.h"
 
 class NetworkClient {
 public:
@@ -26,16 +33,73 @@ public:
 
     // ✅ [修复报错] 补上这个函数的声明
     std::string SendRequest(const std::string& endpoint);
+    // 预先连上服务器 (不阻塞)，之后的请求复用这条 keep-alive 连接
+    void Prewarm();
+
+    // 上传音频的编码 (默认 CHAT_UPLOAD_CODEC)，对之后的内存上传和流式上传生效
+    void SetUploadCodec(AudioEncoder::Codec codec) { upload_codec_.store(codec); }
+    AudioEncoder::Codec UploadCodec() const { return (AudioEncoder::Codec)upload_codec_.load(); }
 
-    // 上传音频
+    // 上传音频 (文件原样上传，不编码)
     std::string SendAudio(const std::string& filepath, bool& out_should_exit);
+    // 上传内存中的音频 (整个 WAV 文件)，不经过文件系统；filename 只是表单里的文件名
+    // 编码不是 PCM 时先压缩，编码方式放在表单的 codec 字段里
+    std::string SendAudio(const void* data, size_t size, const std::string& filename, bool& out_should_exit);
     // 下载文件
     bool DownloadFile(const std::string& url_path, const std::string& save_path);
+    // 流式下载：每收到一块数据就交给 sink (在网络线程里回调)，sink 返回 false 则中止下载
+    typedef NetRequest::DataSink DataSink;
+    bool DownloadStream(const std::string& url_path, DataSink sink, void* userdata);
+
+    // --- 非阻塞请求 (NetworkWorker 在后台执行，调用方轮询 Finished()) ---
+    // 上传内存中的音频，回复用 ParseReply() 取出
+    // reply 不为空时要求服务器把回复音频直接放在响应里 (单次往返)，响应体交给 reply 解析
+    NetRequestPtr SendAudioAsync(const void* data, size_t size, const std::string& filename,
+                                 ChatReplyParser* reply = nullptr);
+    // 流式下载；on_complete 在网络线程里调用 (成功、失败、取消都会调用)
+    NetRequestPtr DownloadStreamAsync(const std::string& url_path, DataSink sink, void* userdata,
+                                      NetRequest::Callback on_complete);
+    void Cancel(const NetRequestPtr& req) { worker_.Cancel(req); }
+    // 解析已结束的上传请求的 JSON 回复；请求失败或回复不是合法 JSON 时返回 false
+    static bool ParseReply(const NetRequest& req, ChatReply& out);
+    // 单次往返模式：元数据由解析器给出 (不用等请求结束)
+    static bool ParseReply(const ChatReplyParser& reply, ChatReply& out);
+
+    // --- 流式上传 (边说边传) ---
+    // 开始一个分块传输 (Transfer-Encoding: chunked) 的 POST，StreamWrite 写入 16bit 单声道 PCM，
+    // 按 UploadCodec() 编码后发送 (X-Audio-Codec 头)
+    // 请求由网络线程驱动，StreamWrite 只把数据追加到待发送缓冲区
+    // reply 的含义同 SendAudioAsync
+    bool StreamBegin(const std::string& endpoint, unsigned int sample_rate, ChatReplyParser* reply = nullptr);
+    void StreamWrite(const void* data, size_t size);
+    // 数据发完了 (发送结束块)，不等服务器回复
+    void StreamEnd();
+    // 交出流式请求，由调用方轮询结果 (ParseReply)；之后 StreamActive() 为 false
+    NetRequestPtr StreamTake();
+    // 阻塞等待服务器回复并结束本次流式请求；失败时返回空字符串
+    std::string StreamResult(bool& out_should_exit);
+    bool StreamActive() const { return stream_ != nullptr; }
+    // 放弃当前流式请求 (会话中途结束时)，等网络线程把它移除后返回
+    void StreamAbort();
 
 private:
     // 私有构造函数
-    NetworkClient() {}
-    ~NetworkClient() {}
+    NetworkClient();
+    ~NetworkClient();
+
+    // 填好 URL/header 后把上传请求交给网络线程
+    NetRequestPtr PostAudioAsync(CURL* curl, curl_mime* mime, ChatReplyParser* reply);
+    // 上传请求的回复处理：分帧回复交给 reply；服务器不支持编码 (415) 时改回 PCM
+    void AttachReply(NetRequest& req, ChatReplyParser* reply);
+    void LogUploadCodec(const AudioEncoder& encoder) const;
+
+    // 先声明 pool_：worker_ 析构时结束的请求还要把句柄还给它
+    CurlHandlePool pool_;
+    NetworkWorker worker_;
+    NetRequestPtr stream_;   // 当前的流式上传 (只由主循环访问)
+    AudioEncoder stream_encoder_;
+    std::vector<uint8_t> encode_buf_;
+    std::atomic<int> upload_codec_;   // 网络线程收到 415 时会改
 
     std::string server_ip_ = "192.168.137.1";
     int port_ = 5000;
@@ -0,0 +1,357 @@
+#include "NetworkWorker.h"
+#include "common/config.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+#include <time.h>
+
+// 没有网络事件时 curl_multi_poll 最多睡这么久 (ms)，超时检查由 libcurl 自己负责
+#define WORKER_POLL_MS 100
+
+// ==========================================
+// CurlHandlePool
+// ==========================================
+
+CurlHandlePool::CurlHandlePool() {
+    curl_global_init(CURL_GLOBAL_ALL);
+    // DNS 结果和空闲连接在所有句柄之间共享 (包括 curl_easy_perform 的阻塞调用)
+    share_ = curl_share_init();
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, LockShare);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, UnlockShare);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+}
+
+CurlHandlePool::~CurlHandlePool() {
+    for (CURL* easy : free_) curl_easy_cleanup(easy);
+    // 句柄全部释放之后 share 才能清理
+    curl_share_cleanup(share_);
+}
+
+CURL* CurlHandlePool::Acquire() {
+    CURL* easy = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty()) {
+            easy = free_.back();
+            free_.pop_back();
+        }
+    }
+    if (easy) {
+        // 清掉上一个请求的选项；连接和 DNS 缓存不受影响
+        curl_easy_reset(easy);
+    } else {
+        easy = curl_easy_init();
+        if (!easy) return nullptr;
+    }
+
+    curl_easy_setopt(easy, CURLOPT_SHARE, share_);
+    // 多线程下不能用 SIGALRM 做 DNS 超时
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    // 空闲连接保留得比默认 (118s) 更久；TCP keep-alive 防止中间设备 (NAT/热点) 悄悄断开
+    curl_easy_setopt(easy, CURLOPT_MAXAGE_CONN, (long)NET_CONN_MAX_AGE_S);
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPIDLE, 30L);
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPINTVL, 15L);
+    return easy;
+}
+
+void CurlHandlePool::Release(CURL* easy) {
+    if (!easy) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.size() < NET_HANDLE_POOL_SIZE) {
+            free_.push_back(easy);
+            return;
+        }
+    }
+    curl_easy_cleanup(easy);
+}
+
+void CurlHandlePool::LockShare(CURL*, curl_lock_data data, curl_lock_access, void* userp) {
+    ((CurlHandlePool*)userp)->share_locks_[data].lock();
+}
+
+void CurlHandlePool::UnlockShare(CURL*, curl_lock_data data, void* userp) {
+    ((CurlHandlePool*)userp)->share_locks_[data].unlock();
+}
+
+// ==========================================
+// NetRequest
+// ==========================================
+
+// libcurl 回调 (运行在网络线程)，需要访问 NetRequest 的私有成员
+struct NetRequestCallbacks {
+    static size_t Write(void* ptr, size_t size, size_t nmemb, void* userp) {
+        NetRequest* req = (NetRequest*)userp;
+        size_t n = size * nmemb;
+        if (req->sink_) {
+            // 返回值不等于收到的字节数时 libcurl 会中止传输
+            return req->sink_(ptr, n, req->sink_userdata_) ? n : 0;
+        }
+        req->body_.append((const char*)ptr, n);
+        return n;
+    }
+
+    // 分块上传：没有数据时暂停传输，调用方 EndBody 后返回 0 发送结束块
+    static size_t Read(char* buffer, size_t size, size_t nitems, void* userp) {
+        NetRequest* req = (NetRequest*)userp;
+        std::lock_guard<std::mutex> lock(req->upload_mutex_);
+
+        if (req->upload_pending_.empty()) {
+            if (req->upload_ended_) {
+                // libcurl 只在前面的数据都写进 socket 之后才再来读，这里就是上传完成的时刻
+                if (!req->upload_end_us_.load(std::memory_order_relaxed)) {
+                    struct timespec ts;
+                    clock_gettime(CLOCK_MONOTONIC, &ts);
+                    req->upload_end_us_.store((uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000,
+                                              std::memory_order_release);
+                }
+                return 0;
+            }
+            req->upload_paused_ = true;
+            return CURL_READFUNC_PAUSE;
+        }
+        size_t n = std::min(size * nitems, req->upload_pending_.size());
+        memcpy(buffer, req->upload_pending_.data(), n);
+        req->upload_pending_.erase(0, n);
+        req->upload_sent_ += n;
+        return n;
+    }
+};
+
+NetRequest::NetRequest(CURL* easy, long timeout_ms, CurlHandlePool* pool)
+    : easy_(easy), pool_(pool), timeout_ms_(timeout_ms) {
+}
+
+NetRequest::~NetRequest() {
+    if (mime_) curl_mime_free(mime_);
+    if (headers_) curl_slist_free_all(headers_);
+    if (!easy_) return;
+    if (pool_) {
+        pool_->Release(easy_);
+    } else {
+        curl_easy_cleanup(easy_);
+    }
+}
+
+void NetRequest::UseStreamingBody() {
+    curl_easy_setopt(easy_, CURLOPT_POST, 1L);
+    curl_easy_setopt(easy_, CURLOPT_READFUNCTION, NetRequestCallbacks::Read);
+    curl_easy_setopt(easy_, CURLOPT_READDATA, this);
+}
+
+void NetRequest::AppendBody(const void* data, size_t size) {
+    std::lock_guard<std::mutex> lock(upload_mutex_);
+    if (upload_ended_ || Finished()) return;
+    upload_pending_.append((const char*)data, size);
+}
+
+void NetRequest::EndBody() {
+    std::lock_guard<std::mutex> lock(upload_mutex_);
+    upload_ended_ = true;
+}
+
+size_t NetRequest::BodyBytesSent() const {
+    std::lock_guard<std::mutex> lock(upload_mutex_);
+    return upload_sent_;
+}
+
+// ==========================================
+// NetworkWorker
+// ==========================================
+
+NetworkWorker::NetworkWorker() {
+    curl_global_init(CURL_GLOBAL_ALL);
+    multi_ = curl_multi_init();
+}
+
+NetworkWorker::~NetworkWorker() {
+    Stop();
+    curl_multi_cleanup(multi_);
+}
+
+void NetworkWorker::Start() {
+    std::lock_guard<std::mutex> lock(start_mutex_);
+    if (running_.load()) return;
+    running_.store(true);
+    thread_ = std::thread(&NetworkWorker::WorkerLoop, this);
+}
+
+void NetworkWorker::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(start_mutex_);
+        if (!running_.load()) return;
+        running_.store(false);
+    }
+    curl_multi_wakeup(multi_);
+    if (thread_.joinable()) thread_.join();
+}
+
+NetRequestPtr NetworkWorker::Submit(const NetRequestPtr& req) {
+    Start();
+    {
+        std::lock_guard<std::mutex> lock(submit_mutex_);
+        submitted_.push_back(req);
+    }
+    curl_multi_wakeup(multi_);
+    return req;
+}
+
+void NetworkWorker::Cancel(const NetRequestPtr& req) {
+    if (!req || req->Finished()) return;
+    req->cancel_.store(true);
+    curl_multi_wakeup(multi_);
+}
+
+void NetworkWorker::Resume(const NetRequestPtr& req) {
+    if (!req || req->Finished()) return;
+    req->resume_.store(true);
+    curl_multi_wakeup(multi_);
+}
+
+bool NetworkWorker::Wait(const NetRequestPtr& req, long timeout_ms) {
+    if (!req) return true;
+    std::unique_lock<std::mutex> lock(done_mutex_);
+    if (timeout_ms < 0) {
+        done_cv_.wait(lock, [&req] { return req->Finished(); });
+        return true;
+    }
+    return done_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                             [&req] { return req->Finished(); });
+}
+
+// ==========================================
+// 网络线程
+// ==========================================
+
+void NetworkWorker::WorkerLoop() {
+    while (running_.load()) {
+        AdoptSubmitted();
+        ServiceActive();
+
+        int still_running = 0;
+        curl_multi_perform(multi_, &still_running);
+        ReapFinished();
+
+        curl_multi_poll(multi_, NULL, 0, WORKER_POLL_MS, NULL);
+    }
+
+    // 退出前把没做完的请求都标记为取消，等待者不会永远挂着
+    AdoptSubmitted();
+    std::vector<NetRequestPtr> left = active_;
+    for (const NetRequestPtr& req : left) Finish(req, NetRequest::kCancelled, CURLE_OK);
+}
+
+void NetworkWorker::AdoptSubmitted() {
+    std::vector<NetRequestPtr> incoming;
+    {
+        std::lock_guard<std::mutex> lock(submit_mutex_);
+        incoming.swap(submitted_);
+    }
+
+    for (const NetRequestPtr& req : incoming) {
+        CURL* easy = req->easy_;
+        curl_easy_setopt(easy, CURLOPT_PRIVATE, req.get());
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, NetRequestCallbacks::Write);
+        curl_easy_setopt(easy, CURLOPT_WRITEDATA, req.get());
+        if (req->timeout_ms_ > 0) curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, req->timeout_ms_);
+
+        active_.push_back(req);
+        if (req->cancel_.load() || !running_.load()) {
+            Finish(req, NetRequest::kCancelled, CURLE_OK);
+            continue;
+        }
+        curl_multi_add_handle(multi_, easy);
+        req->state_.store(NetRequest::kRunning, std::memory_order_release);
+    }
+}
+
+void NetworkWorker::ServiceActive() {
+    std::vector<NetRequestPtr> cancelled;
+    for (const NetRequestPtr& req : active_) {
+        if (req->cancel_.load()) {
+            cancelled.push_back(req);
+            continue;
+        }
+        if (req->resume_.exchange(false)) {
+            bool was_paused;
+            {
+                std::lock_guard<std::mutex> lock(req->upload_mutex_);
+                was_paused = req->upload_paused_;
+                req->upload_paused_ = false;
+            }
+            // 读回调只在本线程运行，这里解除暂停后它会马上被再次调用
+            if (was_paused) curl_easy_pause(req->easy_, CURLPAUSE_CONT);
+        }
+    }
+    for (const NetRequestPtr& req : cancelled) Finish(req, NetRequest::kCancelled, CURLE_OK);
+}
+
+void NetworkWorker::ReapFinished() {
+    CURLMsg* msg;
+    int left = 0;
+    while ((msg = curl_multi_info_read(multi_, &left)) != NULL) {
+        if (msg->msg != CURLMSG_DONE) continue;
+
+        NetRequest* raw = nullptr;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&raw);
+        CURLcode code = msg->data.result;
+
+        for (const NetRequestPtr& req : active_) {
+            if (req.get() == raw) {
+                NetRequestPtr keep = req;
+                Finish(keep, code == CURLE_OK ? NetRequest::kDone : NetRequest::kFailed, code);
+                break;
+            }
+        }
+    }
+}
+
+void NetworkWorker::CollectTiming(NetRequest& req) {
+    NetTiming& t = req.timing_;
+    curl_easy_getinfo(req.easy_, CURLINFO_NAMELOOKUP_TIME_T, &t.dns_us);
+    curl_easy_getinfo(req.easy_, CURLINFO_CONNECT_TIME_T, &t.connect_us);
+    curl_easy_getinfo(req.easy_, CURLINFO_PRETRANSFER_TIME_T, &t.pretransfer_us);
+    curl_easy_getinfo(req.easy_, CURLINFO_STARTTRANSFER_TIME_T, &t.first_byte_us);
+    curl_easy_getinfo(req.easy_, CURLINFO_TOTAL_TIME_T, &t.total_us);
+    curl_easy_getinfo(req.easy_, CURLINFO_NUM_CONNECTS, &t.new_connects);
+
+#if NET_LOG_TIMING
+    char* url = nullptr;
+    curl_easy_getinfo(req.easy_, CURLINFO_EFFECTIVE_URL, &url);
+    // 复用连接时 dns/connect 接近 0，两者之差就是省下的握手时间
+    printf("[Network] %s: dns %.1f ms, connect %.1f ms, first byte %.1f ms, total %.1f ms (%s)\n",
+           url ? url : "?", t.dns_us / 1000.0, t.connect_us / 1000.0,
+           t.first_byte_us / 1000.0, t.total_us / 1000.0,
+           t.new_connects ? "new connection" : "reused connection");
+#endif
+}
+
+void NetworkWorker::Finish(const NetRequestPtr& req, NetRequest::State state, CURLcode code) {
+    NetRequestPtr keep = req;  // 从 active_ 删除后还要用
+    active_.erase(std::remove(active_.begin(), active_.end(), keep), active_.end());
+
+    if (req->GetState() == NetRequest::kRunning) curl_multi_remove_handle(multi_, req->easy_);
+    curl_easy_getinfo(req->easy_, CURLINFO_RESPONSE_CODE, &req->http_status_);
+    if (state != NetRequest::kCancelled) CollectTiming(*req);
+    if (state == NetRequest::kFailed) {
+        req->error_ = curl_easy_strerror(code);
+        std::cerr << "❌ [Network] Request failed: " << req->error_ << std::endl;
+    } else if (state == NetRequest::kCancelled) {
+        req->error_ = "cancelled";
+    }
+
+    // 回调里可以查 GetState()；回调执行完才发布 Finished()，轮询者看到时回调做的事已经完成
+    req->state_.store(state, std::memory_order_release);
+    if (req->on_complete_) req->on_complete_(*req);
+
+    {
+        std::lock_guard<std::mutex> lock(done_mutex_);
+        req->finished_.store(true, std::memory_order_release);
+    }
+    done_cv_.notify_all();
+}
@@ -0,0 +1,193 @@
+/**
+ * @file NetworkWorker.h
+ * @brief 基于 curl_multi 的非阻塞网络线程 (Network Worker)
+ *
+ * 主循环 (UI + 状态机) 不再调用阻塞的 curl_easy_perform:
+ * 1. 调用方准备好 easy 句柄，包装成 NetRequest 后 Submit()，立即返回。
+ * 2. 后台线程用一个 curl_multi 驱动所有进行中的请求，curl_multi_poll 等待网络事件，
+ *    有新请求/取消/恢复时用 curl_multi_wakeup 叫醒。
+ * 3. 调用方轮询 NetRequest::Finished()，或者注册完成回调 (在网络线程里调用，要短)。
+ * 4. 每个请求有自己的超时 (CURLOPT_TIMEOUT_MS)，可以随时 Cancel()。
+ * 5. 分块上传的请求体可以边产生边发送：没数据时读回调返回 CURL_READFUNC_PAUSE，
+ *    调用方追加数据后 Resume()，由网络线程 curl_easy_pause 继续。
+ * 6. easy 句柄从 CurlHandlePool 借出、用完归还；池里的句柄共享 DNS 缓存和连接缓存 (CURLSH)，
+ *    下一个请求直接复用 keep-alive 连接，省掉 TCP 握手。
+ */
+
+#ifndef NETWORK_WORKER_H
+#define NETWORK_WORKER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <curl/curl.h>
+
+class NetRequest;
+typedef std::shared_ptr<NetRequest> NetRequestPtr;
+
+// 可复用的 easy 句柄池 (线程安全)
+class CurlHandlePool {
+public:
+    CurlHandlePool();
+    ~CurlHandlePool();
+
+    CurlHandlePool(const CurlHandlePool&) = delete;
+    void operator=(const CurlHandlePool&) = delete;
+
+    // 借出一个已重置、挂好共享缓存和 keep-alive 选项的句柄
+    CURL* Acquire();
+    // 归还句柄；池满时直接释放
+    void Release(CURL* easy);
+
+private:
+    static void LockShare(CURL* easy, curl_lock_data data, curl_lock_access access, void* userp);
+    static void UnlockShare(CURL* easy, curl_lock_data data, void* userp);
+
+    CURLSH* share_ = nullptr;
+    std::mutex share_locks_[CURL_LOCK_DATA_LAST];
+
+    std::mutex mutex_;
+    std::vector<CURL*> free_;
+};
+
+// 一次请求各阶段的耗时 (微秒，从请求开始算起，见 CURLINFO_*_TIME_T)
+struct NetTiming {
+    curl_off_t dns_us = 0;         // 域名解析完成
+    curl_off_t connect_us = 0;     // TCP 连接建立
+    curl_off_t pretransfer_us = 0; // 开始发送请求
+    curl_off_t first_byte_us = 0;  // 收到第一个响应字节
+    curl_off_t total_us = 0;
+    long new_connects = 0;         // 为这个请求新建的连接数，0 表示复用了已有连接
+};
+
+class NetRequest {
+public:
+    enum State {
+        kPending = 0,    // 已提交，网络线程还没接手
+        kRunning = 1,
+        kDone = 2,       // 传输完成 (HTTP 状态码见 HttpStatus)
+        kFailed = 3,     // 传输出错或超时 (见 Error)
+        kCancelled = 4,
+    };
+
+    // 完成回调，在网络线程里调用
+    typedef std::function<void(NetRequest&)> Callback;
+    // 响应体的去处：返回 false 会中止传输；不设置时响应体存进 Body()
+    typedef bool (*DataSink)(const void* data, size_t size, void* userdata);
+
+    // 接管 easy 句柄 (以及可选的 mime/header 链表)，请求结束后统一释放；
+    // 句柄来自 pool 时归还给 pool，连接留着给下一个请求
+    NetRequest(CURL* easy, long timeout_ms, CurlHandlePool* pool = nullptr);
+    ~NetRequest();
+
+    NetRequest(const NetRequest&) = delete;
+    void operator=(const NetRequest&) = delete;
+
+    void SetMime(curl_mime* mime) { mime_ = mime; }
+    void SetHeaders(struct curl_slist* headers) { headers_ = headers; }
+    void SetSink(DataSink sink, void* userdata) { sink_ = sink; sink_userdata_ = userdata; }
+    void OnComplete(Callback cb) { on_complete_ = cb; }
+    // 请求体改为分块上传，数据由 AppendBody()/EndBody() 陆续提供
+    void UseStreamingBody();
+
+    // --- 分块上传的请求体 (任意线程) ---
+    void AppendBody(const void* data, size_t size);
+    void EndBody();
+    size_t BodyBytesSent() const;
+    // 读回调返回结束 (请求体最后一个字节已交给 libcurl) 的时刻，CLOCK_MONOTONIC 微秒
+    // 和 AudioProcess::NowUs() 同一时间轴；任意线程可读，0 表示还没发完
+    uint64_t UploadEndUs() const { return upload_end_us_.load(std::memory_order_acquire); }
+
+    // --- 结果 (Finished() 之后才有效) ---
+    State GetState() const { return (State)state_.load(std::memory_order_acquire); }
+    // 完成回调执行完之后才为 true
+    bool Finished() const { return finished_.load(std::memory_order_acquire); }
+    bool Succeeded() const { return GetState() == kDone; }
+    const std::string& Body() const { return body_; }
+    long HttpStatus() const { return http_status_; }
+    const std::string& Error() const { return error_; }
+    const NetTiming& Timing() const { return timing_; }
+    CURL* Easy() const { return easy_; }
+
+private:
+    friend class NetworkWorker;
+    friend struct NetRequestCallbacks;
+
+    CURL* easy_;
+    CurlHandlePool* pool_;
+    curl_mime* mime_ = nullptr;
+    struct curl_slist* headers_ = nullptr;
+    long timeout_ms_;
+
+    DataSink sink_ = nullptr;
+    void* sink_userdata_ = nullptr;
+    Callback on_complete_;
+
+    std::string body_;
+    std::string error_;
+    long http_status_ = 0;
+    NetTiming timing_;
+
+    std::atomic<int> state_{kPending};
+    std::atomic<bool> finished_{false};
+    std::atomic<bool> cancel_{false};
+
+    // 分块上传
+    mutable std::mutex upload_mutex_;
+    std::string upload_pending_;
+    size_t upload_sent_ = 0;
+    bool upload_ended_ = false;
+    bool upload_paused_ = false;         // 读回调返回了 PAUSE，等待 Resume
+    std::atomic<bool> resume_{false};    // 有新数据，网络线程需要 curl_easy_pause(CONT)
+    std::atomic<uint64_t> upload_end_us_{0};
+};
+
+class NetworkWorker {
+public:
+    NetworkWorker();
+    ~NetworkWorker();
+
+    NetworkWorker(const NetworkWorker&) = delete;
+    void operator=(const NetworkWorker&) = delete;
+
+    // 第一次 Submit 时会自动 Start
+    void Start();
+    void Stop();
+
+    // 提交请求，立即返回；返回值即传入的 req，方便链式调用
+    NetRequestPtr Submit(const NetRequestPtr& req);
+    // 取消请求 (未开始或进行中都可以)，请求最终进入 kCancelled 并触发完成回调
+    void Cancel(const NetRequestPtr& req);
+    // 分块上传有了新数据，叫醒网络线程继续发送
+    void Resume(const NetRequestPtr& req);
+    // 阻塞等待请求结束；timeout_ms < 0 表示一直等。返回请求是否已结束
+    bool Wait(const NetRequestPtr& req, long timeout_ms = -1);
+
+private:
+    void WorkerLoop();
+    void AdoptSubmitted();
+    void ServiceActive();
+    void ReapFinished();
+    void Finish(const NetRequestPtr& req, NetRequest::State state, CURLcode code);
+    void CollectTiming(NetRequest& req);
+
+    CURLM* multi_ = nullptr;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::mutex start_mutex_;
+
+    std::mutex submit_mutex_;
+    std::vector<NetRequestPtr> submitted_;   // 等待网络线程接手
+    std::vector<NetRequestPtr> active_;      // 只由网络线程访问
+
+    std::mutex done_mutex_;
+    std::condition_variable done_cv_;
+};
+
+#endif // NETWORK_WORKER_H
@@ -0,0 +1,58 @@
+#include "WakeGate.h"
+#include "common/config.h"
+#include "services/audio/AudioKernels.h"
+
+// 噪声底的下限 (均方值)，避免数字静音时噪声底变成 0、任何声音都算 "很多倍"
+#define WAKE_GATE_FLOOR_MIN 16
+
+WakeGate::WakeGate(unsigned int sample_rate) : rate_(sample_rate) {
+    Reset();
+}
+
+void WakeGate::Reset() {
+    floor_ = 0;
+    last_energy_ = 0;
+    hang_samples_ = 0;
+    opens_.store(0, std::memory_order_relaxed);
+}
+
+bool WakeGate::Process(const int16_t* data, size_t n) {
+    if (n == 0) return IsOpen();
+
+    // 1. 均方值和过零率 (每 1000 对样本的过零次数)
+    uint32_t energy = (uint32_t)(AudioKernels::Energy(data, n) / n);
+    uint32_t zcr = n > 1 ? (uint32_t)((uint64_t)AudioKernels::ZeroCrossings(data, n) * 1000 / (n - 1)) : 0;
+    last_energy_ = energy;
+
+    // 第一帧直接作为噪声底的初值，不用从 0 慢慢爬上来
+    if (floor_ == 0) floor_ = energy > WAKE_GATE_FLOOR_MIN ? energy : WAKE_GATE_FLOOR_MIN;
+
+    // 2. 开门判定 (整数比较，不开方)
+    const uint32_t min_energy = (uint32_t)WAKE_GATE_MIN_RMS * WAKE_GATE_MIN_RMS;
+    uint64_t floor = floor_;
+    bool trigger = energy >= min_energy &&
+                   ((uint64_t)energy >= floor * WAKE_GATE_ENERGY_RATIO ||
+                    ((uint64_t)energy >= floor * 2 && zcr >= WAKE_GATE_ZCR_MIN));
+
+    bool pass;
+    if (trigger) {
+        if (!IsOpen()) opens_.store(opens_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        hang_samples_ = (size_t)rate_ * WAKE_GATE_HANG_MS / 1000;
+        pass = true;
+    } else {
+        pass = IsOpen();
+        hang_samples_ = hang_samples_ > n ? hang_samples_ - n : 0;
+    }
+
+    // 3. 噪声底：更小的能量快速跟下去，更大的能量缓慢跟上去
+    //    开着门也要跟：持续的响声 (电视、风扇) 几秒后会被当成新的底噪，门随之关上
+    if (energy < floor_) {
+        floor_ -= (floor_ - energy) / 4;
+    } else {
+        floor_ += (floor_ >> 5) + 1;
+        if (floor_ > energy) floor_ = energy;
+    }
+    if (floor_ < WAKE_GATE_FLOOR_MIN) floor_ = WAKE_GATE_FLOOR_MIN;
+
+    return pass;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file WakeGate.h
+ * @brief 唤醒词检测的前级能量门 (Snowboy 之前的廉价一级)
+ *
+ * 安静的房间里 Snowboy 也要对每个 64ms 帧跑一遍神经网络，这是待机 CPU/功耗的大头。
+ * 这里先用整数运算算一下帧能量和过零率，明显是静音的帧直接跳过 Snowboy:
+ * 1. 噪声底：比当前能量低时缓慢上升 (每帧约 3%)，遇到更小的能量快速下降，跟着环境噪声走。
+ * 2. 开门：能量超过噪声底 WAKE_GATE_ENERGY_RATIO 倍；或者能量超过 2 倍且过零率高
+ *    ("Snowboy" 开头的 s 这种清擦音能量低、过零多，单看能量容易漏)。
+ *    无论哪种，能量都要高于 WAKE_GATE_MIN_RMS，数字静音不会开门。
+ * 3. 开门后保持 WAKE_GATE_HANG_MS，整个唤醒词说完之前不会中途关上。
+ *
+ * 开门之前的那一小段音频 (lookback) 不在这里缓存：录音环形缓冲区本身就保存着历史，
+ * 调用方在刚开门时把游标往回拨 WAKE_GATE_LOOKBACK_MS 重新喂给 Snowboy 即可。
+ */
+
+#ifndef WAKE_GATE_H
+#define WAKE_GATE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class WakeGate {
+public:
+    explicit WakeGate(unsigned int sample_rate = 16000);
+
+    // 回到初始状态 (门关着，噪声底重新估计)
+    void Reset();
+
+    // 处理一帧；返回 true 表示这一帧要交给 Snowboy
+    bool Process(const int16_t* data, size_t n);
+
+    bool IsOpen() const { return hang_samples_ > 0; }
+    // 调试用：最近一帧的均方值和噪声底
+    uint32_t LastEnergy() const { return last_energy_; }
+    uint32_t NoiseFloor() const { return floor_; }
+    // 开门次数 (可从其他线程读取，统计用)
+    uint32_t Opens() const { return opens_.load(std::memory_order_relaxed); }
+
+private:
+    unsigned int rate_;
+    uint32_t floor_;          // 噪声底 (均方值)
+    uint32_t last_energy_;
+    size_t hang_samples_;     // 开门后还要保持多少样本
+    std::atomic<uint32_t> opens_{0};   // 只有检测线程写，LogStats 在主线程读
+};
+
+#endif // WAKE_GATE_H
@@ -10,21 +10,49 @@
 
 #include "WakeWordEngine.h"
 #include "snowboy/snowboy-detect.h"
+#include "common/config.h"
+#include "services/audio/AudioProcess.h"
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
 
-WakeWordEngine::WakeWordEngine() {}
+// 检测线程等一帧数据的最长时间，超时后检查一下是否该退出
+#define WAKE_WAIT_TIMEOUT_MS 200
+
+#if WAKE_GATE_LOOKBACK_MS >= AUDIO_PREROLL_MS
+#error "WAKE_GATE_LOOKBACK_MS must be shorter than the capture history (AUDIO_PREROLL_MS)"
+#endif
+
+static long ThreadCpuUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+WakeWordEngine::WakeWordEngine() : events_(WAKE_EVENT_QUEUE) {
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd_ < 0) perror("[WakeWord] eventfd");
+}
 
 WakeWordEngine::~WakeWordEngine() {
     // unique_ptr 会自动释放 detector_
+    Stop();
+    if (event_fd_ >= 0) close(event_fd_);
 }
 
 bool WakeWordEngine::Init(const std::string& res_path, const std::string& model_path) {
+    // 模型只加载一次，第二个使用方直接共用
+    if (is_initialized_) return true;
     try {
         // 创建检测器
         detector_.reset(new snowboy::SnowboyDetect(res_path, model_path));
 
         // 配置参数 (保持和你之前的一致)
-        detector_->SetSensitivity("0.5");
+        detector_->SetSensitivity(SNOWBOY_SENSITIVITY);
         detector_->SetAudioGain(1.0);
         detector_->ApplyFrontend(false);
 
@@ -38,14 +66,211 @@ bool WakeWordEngine::Init(const std::string& res_path, const std::string& model_
     }
 }
 
+void WakeWordEngine::Reset() {
+    std::lock_guard<std::mutex> lock(detector_mutex_);
+    if (is_initialized_ && detector_) detector_->Reset();
+}
+
 int WakeWordEngine::Detect(const std::vector<int16_t>& data) {
     return Detect(data.data(), data.size());
 }
 
-int WakeWordEngine::Detect(const int16_t* data, int len) {
+int WakeWordEngine::Detect(const int16_t* data, size_t len) {
     if (!is_initialized_ || !detector_) {
         return -1;
     }
     // RunDetection 是 Snowboy 的核心 API
-    return detector_->RunDetection(data, len);
+    std::lock_guard<std::mutex> lock(detector_mutex_);
+    return detector_->RunDetection(data, (int)len);
+}
+
+// ==========================================
+// 后台检测线程
+// ==========================================
+
+bool WakeWordEngine::Start() {
+    if (running_.load()) return true;
+    if (!is_initialized_) return false;
+
+    tap_ = AudioProcess::GetInstance().Subscribe("wake", WAKE_HOP_MS * 16);
+    if (!tap_) {
+        std::cout << "❌ [WakeWord] No free capture tap." << std::endl;
+        return false;
+    }
+    Reset();
+    running_.store(true);
+    thread_ = std::thread(&WakeWordEngine::DetectLoop, this);
+    return true;
+}
+
+void WakeWordEngine::Stop() {
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+    AudioProcess::GetInstance().Unsubscribe(tap_);
+    tap_ = nullptr;
+}
+
+void WakeWordEngine::SetEnabled(bool enabled) {
+    if (enabled && !enabled_.load()) {
+        // 暂停那一刻正在测的那帧可能还发出过事件，恢复时丢掉，免得一回到桌面就又被唤醒
+        WakeEvent stale;
+        while (PollEvent(stale)) {}
+        resume_.store(true);
+    }
+    enabled_.store(enabled);
+}
+
+void WakeWordEngine::DetectLoop() {
+    AudioProcess& audio = AudioProcess::GetInstance();
+    // 每次处理一个 hop (WAKE_HOP_MS)，直接读环形缓冲区里的视图；只有跨过回绕点时才拼到 scratch
+    const size_t hop = tap_->Hop();
+    std::vector<int16_t> scratch(hop);
+    const uint64_t frame_us = hop * 1000000ULL / 16000;
+    // 往回拨的长度取整到帧，重放的最后一帧正好停在开门的那一帧
+    const size_t lookback_frames = (WAKE_GATE_LOOKBACK_MS * 16 + hop - 1) / hop;
+    bool gate_on = gate_enabled_.load();
+    uint64_t replay_until = 0;   // 开门时往回拨，这个位置之前的帧是重放，直接交给 Snowboy
+    std::cout << "[WakeWord] Detection thread started (gate " << (gate_on ? "on" : "off") << ")." << std::endl;
+
+    while (running_.load()) {
+        if (!audio.WaitCapture(tap_, hop, WAKE_WAIT_TIMEOUT_MS)) continue;
+
+        // 对话期间不做唤醒检测，跳过这段音频，避免回到桌面时处理积压的旧数据
+        if (!enabled_.load()) {
+            tap_->Clear();
+            continue;
+        }
+        if (resume_.exchange(false)) {
+            tap_->Clear();
+            Reset();
+            gate_.Reset();
+            replay_until = 0;
+            continue;
+        }
+        // 能量门开关切换：先把上一种模式的 CPU 占用打出来，方便对比
+        if (gate_enabled_.load() != gate_on) {
+            LogCpu();
+            ResetCpuStats();
+            gate_on = !gate_on;
+            gate_.Reset();
+            replay_until = 0;
+            std::cout << "[WakeWord] Energy gate " << (gate_on ? "on" : "off") << "." << std::endl;
+        }
+
+        long cpu_start = ThreadCpuUs();
+        // 一次把积压的帧都处理完，不会一轮只测一帧
+        CaptureView view;
+        while (enabled_.load() && tap_->Peek(view)) {
+            const int16_t* frame = view.Data(scratch.data());
+            uint64_t pos = view.EndPos();
+            bool replay = pos <= replay_until;
+            if (!replay) {
+                frames_.fetch_add(1, std::memory_order_relaxed);
+                audio_us_.fetch_add(frame_us, std::memory_order_relaxed);
+            }
+
+            // 第一级：能量门关着就不跑 Snowboy
+            if (gate_on && !replay) {
+                bool was_open = gate_.IsOpen();
+                if (!gate_.Process(frame, hop)) {
+                    tap_->Consume(view);
+                    continue;
+                }
+                if (!was_open) {
+                    // 刚开门：Snowboy 里还是很久以前的音频，清掉后从 lookback 之前重新听，
+                    // 唤醒词开头那一小段 (开门之前、能量还不够的部分) 不会丢
+                    Reset();
+                    replay_until = pos;
+                    uint64_t back = hop * (lookback_frames + 1);
+                    tap_->Seek(pos > back ? pos - back : 0);
+                    continue;   // 不 Consume：游标已经拨回去了
+                }
+            }
+
+            // 第二级：Snowboy
+            long detect_start = ThreadCpuUs();
+            int ret = Detect(frame, hop);
+            snowboy_us_.fetch_add(ThreadCpuUs() - detect_start, std::memory_order_relaxed);
+            if (!replay) frames_detected_.fetch_add(1, std::memory_order_relaxed);
+            // 检测期间这段音频被写者覆盖了 (线程被饿了好几秒)，结果不可信，游标已经跳过丢失的部分
+            if (!tap_->Consume(view)) continue;
+
+            // 这一帧最后一个样本的采集时刻 -> 现在 (重放的帧本来就是旧数据，不计入直方图)
+            uint64_t frame_end_us = audio.TimeAtPos(pos);
+            uint64_t now_us = AudioProcess::NowUs();
+            uint64_t latency_us = now_us > frame_end_us ? now_us - frame_end_us : 0;
+            if (!replay) latency_.Add(latency_us);
+
+            if (ret > 0 && enabled_.load()) {
+                // 唤醒词在刚读完的这一帧里结束
+                WakeEvent event = { ret, frame_end_us, latency_us };
+                if (events_.Write(&event, 1) == 0) {
+                    std::cout << "[WakeWord] Event queue full, wake dropped." << std::endl;
+                    continue;
+                }
+                uint64_t one = 1;
+                if (write(event_fd_, &one, sizeof(one)) < 0) perror("[WakeWord] eventfd write");
+            }
+        }
+        cpu_us_.fetch_add(ThreadCpuUs() - cpu_start, std::memory_order_relaxed);
+
+#if WAKE_STATS_PERIOD_S
+        // 待机时定期报告一次 CPU 占用 (每个窗口重新计数)
+        if (audio_us_.load(std::memory_order_relaxed) >= WAKE_STATS_PERIOD_S * 1000000ULL) {
+            LogCpu();
+            ResetCpuStats();
+        }
+#endif
+    }
+    std::cout << "[WakeWord] Detection thread stopped." << std::endl;
+}
+
+void WakeWordEngine::SetGateEnabled(bool enabled) {
+    gate_enabled_.store(enabled);
+}
+
+void WakeWordEngine::ResetCpuStats() {
+    frames_.store(0, std::memory_order_relaxed);
+    frames_detected_.store(0, std::memory_order_relaxed);
+    audio_us_.store(0, std::memory_order_relaxed);
+    cpu_us_.store(0, std::memory_order_relaxed);
+    snowboy_us_.store(0, std::memory_order_relaxed);
+}
+
+// 检测线程的 CPU 时间占音频时长的比例；再按 Snowboy 每帧的平均耗时估算不开门控时的占用
+void WakeWordEngine::LogCpu() const {
+    uint64_t audio_us = audio_us_.load(std::memory_order_relaxed);
+    if (audio_us == 0) return;
+    uint64_t frames = frames_.load(std::memory_order_relaxed);
+    uint64_t detected = frames_detected_.load(std::memory_order_relaxed);
+    uint64_t cpu_us = cpu_us_.load(std::memory_order_relaxed);
+    uint64_t snowboy_us = snowboy_us_.load(std::memory_order_relaxed);
+    double per_frame_us = detected ? (double)snowboy_us / detected : 0;
+    double gate_off_pct = (cpu_us - std::min(cpu_us, snowboy_us) + per_frame_us * frames) * 100.0 / audio_us;
+    printf("[WakeWord] CPU (gate %s): %.1f s audio, %llu/%llu frames to Snowboy, %u opens, "
+           "thread %.2f%% (Snowboy %.0f us/frame, ~%.2f%% with every frame)\n",
+           gate_enabled_.load() ? "on" : "off", audio_us / 1e6, (unsigned long long)detected,
+           (unsigned long long)frames, gate_.Opens(), cpu_us * 100.0 / audio_us, per_frame_us, gate_off_pct);
+}
+
+bool WakeWordEngine::WaitEvent(int timeout_ms) {
+    if (events_.Available() > 0) return true;
+    struct pollfd pfd = { event_fd_, POLLIN, 0 };
+    return poll(&pfd, 1, timeout_ms) > 0;
+}
+
+bool WakeWordEngine::PollEvent(WakeEvent& event) {
+    // 先清掉 eventfd 的计数，再取队列：之后写入的事件会重新置位，不会漏
+    uint64_t count;
+    while (read(event_fd_, &count, sizeof(count)) > 0) {}
+    return events_.Read(&event, 1) == 1;
+}
+
+void WakeWordEngine::LogStats() const {
+    latency_.Log("wake detect (capture -> decision)");
+    LogCpu();
+    if (tap_) {
+        printf("[WakeWord] Tap lag: %zu, max lag: %zu, dropped: %llu samples (%u overruns)\n",
+               tap_->Lag(), tap_->MaxLag(), (unsigned long long)tap_->DroppedSamples(), tap_->OverrunCount());
+    }
 }
\ No newline at end of file
@@ -1,39 +1,126 @@
 #ifndef WAKE_WORD_ENGINE_H
 #define WAKE_WORD_ENGINE_H
 
+#include <atomic>
+#include <cstddef>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include <cstdint>
 
+#include "common/config.h"
+#include "common/latency_histogram.h"
+#include "services/audio/RingBuffer.h"
+#include "WakeGate.h"
+
 // 前置声明，避免在头文件中引入复杂的 snowboy 头文件
 namespace snowboy {
     class SnowboyDetect;
 }
 
+class CaptureTap;
+
+// 一次唤醒 (检测线程 -> 主循环)
+struct WakeEvent {
+    int index;            // 唤醒词索引 (RunDetection 的返回值，> 0)
+    uint64_t time_us;     // 唤醒词结束的时刻 (AudioProcess 时间轴)，ChatApp 从它之前开始录音
+    uint64_t latency_us;  // 这一帧采集完成到检测出唤醒词用了多久
+};
+
+// 全局唯一的唤醒词检测器：Snowboy 模型 (common.res + umdl) 和 openblas 的状态只有一份，
+// 桌面待机 (检测线程) 和 IdleState 都通过 GetInstance() 使用它。
+// 换了使用方 (状态切换、会话结束回到桌面) 先调用 Reset()，清掉上一个使用方留下的半截音频。
+//
+// 桌面待机时检测跑在自己的线程里 (Start)：
+// 1. 线程订阅自己的录音游标，在 AudioProcess::WaitCapture 上等数据，来一帧测一帧，
+//    不再受主循环里 LVGL 重绘和 usleep 的节奏影响，也不会一轮只处理一帧而越积越多。
+// 2. 检测到唤醒词时把 WakeEvent 放进无锁队列，再写一下 eventfd；
+//    主循环用 WaitEvent() 代替 usleep，有事件时立刻醒来，再用 PollEvent() 取出。
+// 3. 每一帧从采集完成到检测完的延迟记进直方图 (LogStats 打印)。
+// 4. Snowboy 前面有一级能量门 (WakeGate)，安静时跳过 Snowboy；开门时游标往回拨一小段重新喂给它。
+//    线程的 CPU 时间按音频时长统计，门控开/关的占用都会打印出来 (见 LogCpu)。
 class WakeWordEngine {
 public:
-    // 获取单例 (可选，如果你想全局访问)
-    // 或者直接作为普通类在 main 中实例化，这里设计为普通类更灵活
-    WakeWordEngine();
-    ~WakeWordEngine();
+    static WakeWordEngine& GetInstance() {
+        static WakeWordEngine instance;
+        return instance;
+    }
+
+    WakeWordEngine(const WakeWordEngine&) = delete;
+    void operator=(const WakeWordEngine&) = delete;
 
     // 初始化模型
-    // 返回 true 表示加载成功
+    // 返回 true 表示加载成功；已经加载过时直接返回 true，不会重复读盘
     bool Init(const std::string& res_path, const std::string& model_path);
+    bool IsReady() const { return is_initialized_; }
+
+    // 清空检测器内部的音频缓存和 VAD 状态
+    void Reset();
 
-    // 检测一帧音频
+    // 检测一段音频 (直接读调用方的缓冲区，不拷贝)
     // data: 单声道、16k、16bit 的 PCM 数据
-    // 返回值: 
+    // 返回值:
     //   > 0 : 检测到唤醒词 (返回唤醒词索引)
     //   0   : 无事发生
     //   < 0 : 出错
+    int Detect(const int16_t* data, size_t len);
     int Detect(const std::vector<int16_t>& data);
-    int Detect(const int16_t* data, int len);
+
+    // --- 后台检测线程 ---
+    // 启动/停止检测线程 (需要 AudioProcess 已经在运行)
+    bool Start();
+    void Stop();
+    // 暂停/恢复后台检测：对话期间暂停 (录音游标照常前进，数据直接跳过)；
+    // 恢复时线程自己跳到最新的数据并 Reset()，不会处理对话期间积压的旧音频
+    void SetEnabled(bool enabled);
+    // 运行时开关能量门 (对比待机 CPU 用)；切换时先打印上一种模式的 CPU 占用
+    void SetGateEnabled(bool enabled);
+
+    // [主循环] 等待唤醒事件，最多 timeout_ms；有事件 (或已经有未取的事件) 时立刻返回 true
+    bool WaitEvent(int timeout_ms);
+    // [主循环] 取出一个唤醒事件，没有时返回 false
+    bool PollEvent(WakeEvent& event);
+    // 唤醒的文件描述符 (可以放进调用方自己的 poll/epoll)
+    int EventFd() const { return event_fd_; }
+
+    // 打印检测延迟直方图、CPU 占用和检测线程游标的积压/丢帧
+    void LogStats() const;
 
 private:
+    WakeWordEngine();
+    ~WakeWordEngine();
+
+    void DetectLoop();
+    void LogCpu() const;
+    void ResetCpuStats();
+
     std::unique_ptr<snowboy::SnowboyDetect> detector_;
     bool is_initialized_ = false;
+    // 后台线程和 IdleState (主循环) 都会调用检测器，同一时刻只允许一个
+    std::mutex detector_mutex_;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> enabled_{true};
+    std::atomic<bool> resume_{false};    // 刚恢复，线程要先跳过积压的数据
+    CaptureTap* tap_ = nullptr;          // 检测线程专属的录音游标
+
+    SpscRing<WakeEvent> events_;         // 检测线程 -> 主循环
+    int event_fd_ = -1;
+    LatencyHistogram latency_;           // 每帧：采集完成 -> 检测完成
+
+    // 能量门 (只在检测线程里用)
+    WakeGate gate_;
+    std::atomic<bool> gate_enabled_{WAKE_GATE != 0};
+
+    // CPU 统计 (检测线程写，LogStats 可以从其他线程读)
+    std::atomic<uint64_t> frames_{0};           // 处理过的帧
+    std::atomic<uint64_t> frames_detected_{0};  // 其中交给 Snowboy 的 (不含重放)
+    std::atomic<uint64_t> audio_us_{0};         // 处理过的音频时长
+    std::atomic<uint64_t> cpu_us_{0};           // 检测线程的 CPU 时间
+    std::atomic<uint64_t> snowboy_us_{0};       // 其中 Snowboy 的 CPU 时间 (含重放)
 };
 
-#endif // WAKE_WORD_ENGINE_H
\ No newline at end of file
+#endif // WAKE_WORD_ENGINE_H
@@ -0,0 +1,213 @@
+/**
+ * @file audio_kernels_test.cc
+ * @brief AudioKernels 单元测试：本机编译运行 (make test)
+ *
+ * 1. 每个运算核都和这里按定义逐样本写出的期望值比对 (独立于 Scalar 实现)，
+ *    长度从 0 到 70 逐个覆盖，起始地址再错开一个样本，保证向量主体 + 奇数尾巴 + 非对齐都测到。
+ * 2. 满幅/最小值、增益溢出等饱和情况用手算的固定值检查。
+ * 3. 分发后的实现 (ARM 上是 NEON) 和 Scalar 参考实现逐样本一致，SelfTest() 必须通过。
+ *    在 x86 上两者都是标量；交叉编译 + qemu-arm 运行时测的就是 NEON (见 Makefile 的 test 目标)。
+ *
+ * 任何一项失败都打印出来，进程返回非 0，make test 随之失败。
+ */
+
+#include "AudioKernels.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static int g_failures = 0;
+
+#define EXPECT_EQ(a, b, what, len)                                                            \
+    do {                                                                                      \
+        long long va_ = (long long)(a), vb_ = (long long)(b);                                 \
+        if (va_ != vb_) {                                                                     \
+            if (++g_failures <= 20)                                                           \
+                printf("FAIL %s (len %zu): got %lld, expected %lld  [%s:%d]\n", what,         \
+                       (size_t)(len), va_, vb_, __FILE__, __LINE__);                          \
+        }                                                                                     \
+    } while (0)
+
+static int16_t Sat16(int64_t v) {
+    return (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+}
+
+// 随机数据里混进满幅值，饱和路径在每个长度下都会被走到
+static std::vector<int16_t> MakeData(size_t n, uint32_t seed) {
+    std::vector<int16_t> v(n);
+    for (size_t i = 0; i < n; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        if (i % 7 == 3) {
+            v[i] = 32767;
+        } else if (i % 11 == 5) {
+            v[i] = -32768;
+        } else {
+            v[i] = (int16_t)(seed >> 16);
+        }
+    }
+    return v;
+}
+
+// --- 逐样本对照：长度 0..70，起始地址错开 1 个样本 ---
+
+static void TestChannelKernels(size_t frames) {
+    // +1 让数据从奇数地址 (非 16 字节对齐) 开始
+    std::vector<int16_t> src = MakeData(frames * 2 + 1, 0x1234u + (uint32_t)frames);
+    const int16_t* stereo = src.data() + 1;
+    std::vector<int16_t> mono(frames + 1, 0x55), out(frames * 2 + 1, 0x55);
+
+    for (int ch = 0; ch < 2; ++ch) {
+        AudioKernels::Deinterleave(stereo, mono.data() + 1, frames, ch);
+        for (size_t i = 0; i < frames; ++i) EXPECT_EQ(mono[i + 1], stereo[2 * i + ch], "Deinterleave", frames);
+        EXPECT_EQ(mono[0], 0x55, "Deinterleave writes before buffer", frames);
+    }
+
+    AudioKernels::MixDown(stereo, mono.data() + 1, frames);
+    for (size_t i = 0; i < frames; ++i) {
+        // (L + R) / 2 向下取整 (负数也是向负无穷)
+        int32_t sum = (int32_t)stereo[2 * i] + stereo[2 * i + 1];
+        int32_t expect = sum >= 0 ? sum / 2 : -((-sum + 1) / 2);
+        EXPECT_EQ(mono[i + 1], expect, "MixDown", frames);
+    }
+
+    const int16_t* left = stereo;
+    const int16_t* right = stereo + frames;
+    AudioKernels::Interleave(left, right, out.data() + 1, frames);
+    for (size_t i = 0; i < frames; ++i) {
+        EXPECT_EQ(out[2 * i + 1], left[i], "Interleave L", frames);
+        EXPECT_EQ(out[2 * i + 2], right[i], "Interleave R", frames);
+    }
+
+    out.assign(frames * 2 + 2, 0x55);
+    AudioKernels::Duplicate(left, out.data() + 1, frames);
+    for (size_t i = 0; i < frames; ++i) {
+        EXPECT_EQ(out[2 * i + 1], left[i], "Duplicate L", frames);
+        EXPECT_EQ(out[2 * i + 2], left[i], "Duplicate R", frames);
+    }
+    EXPECT_EQ(out[frames * 2 + 1], 0x55, "Duplicate writes past buffer", frames);
+}
+
+static void TestGain(size_t n) {
+    const int32_t gains[] = {0, 1, 2048, 4095, 4096, 5793, 16384, 32767, 100000, -4096, -100000};
+    std::vector<int16_t> src = MakeData(n + 1, 0xBEEFu + (uint32_t)n);
+    for (int32_t gain : gains) {
+        std::vector<int16_t> data(src);
+        AudioKernels::ApplyGain(data.data() + 1, n, gain);
+        // 增益先限制在 int16 范围，再 Q12 四舍五入 (+0.5 向上取整) 并饱和
+        int64_t g = gain > 32767 ? 32767 : (gain < -32768 ? -32768 : gain);
+        for (size_t i = 0; i < n; ++i) {
+            int64_t p = (int64_t)src[i + 1] * g + 2048;
+            int64_t q = p >= 0 ? p / 4096 : -((-p + 4095) / 4096);
+            EXPECT_EQ(data[i + 1], Sat16(q), "ApplyGain", n);
+        }
+        EXPECT_EQ(data[0], src[0], "ApplyGain writes before buffer", n);
+    }
+}
+
+static void TestAnalysis(size_t n) {
+    std::vector<int16_t> src = MakeData(n + 1, 0xC0FFEEu + (uint32_t)n);
+    const int16_t* data = src.data() + 1;
+
+    uint64_t energy = 0;
+    for (size_t i = 0; i < n; ++i) energy += (uint64_t)((int64_t)data[i] * data[i]);
+    EXPECT_EQ(AudioKernels::Energy(data, n), energy, "Energy", n);
+
+    uint32_t zc = 0;
+    for (size_t i = 0; i + 1 < n; ++i) zc += (data[i] < 0) != (data[i + 1] < 0);
+    EXPECT_EQ(AudioKernels::ZeroCrossings(data, n), zc, "ZeroCrossings", n);
+}
+
+// --- 手算的边界值 ---
+
+static void TestSaturation() {
+    const int16_t stereo[] = {32767, 32767, -32768, -32768, 1, -2, -1, 0, 32767, -32768};
+    int16_t mono[5];
+    AudioKernels::MixDown(stereo, mono, 5);
+    EXPECT_EQ(mono[0], 32767, "MixDown max", 5);
+    EXPECT_EQ(mono[1], -32768, "MixDown min", 5);
+    EXPECT_EQ(mono[2], -1, "MixDown floor", 5);
+    EXPECT_EQ(mono[3], -1, "MixDown floor", 5);
+    EXPECT_EQ(mono[4], -1, "MixDown max+min", 5);
+
+    int16_t g[] = {32767, -32768, 3, -3, 1000, -32768, 20000, -20000, 5};
+    const size_t n = sizeof(g) / sizeof(g[0]);
+    int16_t a[n];
+    for (size_t i = 0; i < n; ++i) a[i] = g[i];
+    AudioKernels::ApplyGain(a, n, 32767);       // 约 8 倍
+    EXPECT_EQ(a[0], 32767, "ApplyGain x8 max", n);
+    EXPECT_EQ(a[1], -32768, "ApplyGain x8 min", n);
+    EXPECT_EQ(a[4], 8000, "ApplyGain x8 1000", n);  // (1000 * 32767 + 2048) / 4096 = 8000.2
+    for (size_t i = 0; i < n; ++i) a[i] = g[i];
+    AudioKernels::ApplyGain(a, n, 2048);        // 0.5 倍，四舍五入 (.5 向上)
+    EXPECT_EQ(a[2], 2, "ApplyGain 0.5 * 3", n);
+    EXPECT_EQ(a[3], -1, "ApplyGain 0.5 * -3", n);
+    for (size_t i = 0; i < n; ++i) a[i] = g[i];
+    AudioKernels::ApplyGain(a, n, -4096);       // 反相：-(-32768) 饱和到 32767
+    EXPECT_EQ(a[0], -32767, "ApplyGain invert max", n);
+    EXPECT_EQ(a[1], 32767, "ApplyGain invert min", n);
+    for (size_t i = 0; i < n; ++i) a[i] = g[i];
+    AudioKernels::ApplyGain(a, n, 4096);        // 1.0 倍原样
+    for (size_t i = 0; i < n; ++i) EXPECT_EQ(a[i], g[i], "ApplyGain unity", n);
+    for (size_t i = 0; i < n; ++i) a[i] = g[i];
+    AudioKernels::ApplyGain(a, n, 1000000);     // 超出范围的增益按 32767 处理
+    EXPECT_EQ(a[6], 32767, "ApplyGain clamp gain", n);
+    EXPECT_EQ(a[7], -32768, "ApplyGain clamp gain", n);
+
+    // 全是最小值：每个样本 2^30，累加不能溢出 32 位
+    std::vector<int16_t> loud(1027, -32768);
+    EXPECT_EQ(AudioKernels::Energy(loud.data(), loud.size()), 1027ULL << 30, "Energy full scale", loud.size());
+
+    // 0 算正数
+    const int16_t zc[] = {0, -1, 1, 0, -5};
+    EXPECT_EQ(AudioKernels::ZeroCrossings(zc, 5), 3, "ZeroCrossings", 5);
+    EXPECT_EQ(AudioKernels::ZeroCrossings(zc, 1), 0, "ZeroCrossings single", 1);
+    EXPECT_EQ(AudioKernels::ZeroCrossings(zc, 0), 0, "ZeroCrossings empty", 0);
+}
+
+// --- 分发后的实现 (NEON) 和标量参考实现一致 ---
+
+static void TestMatchesScalar(size_t frames) {
+    std::vector<int16_t> stereo = MakeData(frames * 2, 0xABCDu + (uint32_t)frames);
+    std::vector<int16_t> a(frames * 2), b(frames * 2);
+
+    AudioKernels::MixDown(stereo.data(), a.data(), frames);
+    AudioKernels::Scalar::MixDown(stereo.data(), b.data(), frames);
+    for (size_t i = 0; i < frames; ++i) EXPECT_EQ(a[i], b[i], "MixDown vs scalar", frames);
+
+    a = stereo;
+    b = stereo;
+    AudioKernels::ApplyGain(a.data(), a.size(), 5793);
+    AudioKernels::Scalar::ApplyGain(b.data(), b.size(), 5793);
+    for (size_t i = 0; i < a.size(); ++i) EXPECT_EQ(a[i], b[i], "ApplyGain vs scalar", frames);
+
+    EXPECT_EQ(AudioKernels::Energy(stereo.data(), stereo.size()),
+              AudioKernels::Scalar::Energy(stereo.data(), stereo.size()), "Energy vs scalar", frames);
+    EXPECT_EQ(AudioKernels::ZeroCrossings(stereo.data(), stereo.size()),
+              AudioKernels::Scalar::ZeroCrossings(stereo.data(), stereo.size()), "ZeroCrossings vs scalar", frames);
+}
+
+int main() {
+    printf("AudioKernels test (%s)\n", AudioKernels::UsingNeon() ? "NEON" : "scalar");
+
+    for (size_t n = 0; n <= 70; ++n) {
+        TestChannelKernels(n);
+        TestGain(n);
+        TestAnalysis(n);
+        TestMatchesScalar(n);
+    }
+    TestMatchesScalar(1027);
+    TestSaturation();
+
+    if (!AudioKernels::SelfTest()) {
+        printf("FAIL SelfTest\n");
+        g_failures++;
+    }
+
+    if (g_failures) {
+        printf("%d check(s) FAILED\n", g_failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
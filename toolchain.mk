@@ -9,3 +9,6 @@ STRIP = arm-rockchip830-linux-uclibcgnueabihf-strip
 
 # 可以在这里添加特定于编译器的全局标志
 # TARGET_ARCH = -mcpu=cortex-a7 -mfloat-abi=hard
+
+# RV1106 (Cortex-A7) 带 NEON，打开后 AudioKernels 会编译出 NEON 版本
+ARCH_FLAGS = -mcpu=cortex-a7 -mfpu=neon-vfpv4